@@ -1,194 +1,77 @@
-/*
-   A C-program for MT19937, with initialization improved 2002/1/26.
-   Coded by Takuji Nishimura and Makoto Matsumoto.
-
-   Before using, initialize the state by using init_genrand(seed)
-   or init_by_array(init_key, key_length).
-
-   Copyright (C) 1997 - 2002, Makoto Matsumoto and Takuji Nishimura,
-   All rights reserved.
-   Copyright (C) 2005, Mutsuo Saito,
-   All rights reserved.
-
-   Redistribution and use in source and binary forms, with or without
-   modification, are permitted provided that the following conditions
-   are met:
-
-     1. Redistributions of source code must retain the above copyright
-        notice, this list of conditions and the following disclaimer.
-
-     2. Redistributions in binary form must reproduce the above copyright
-        notice, this list of conditions and the following disclaimer in the
-        documentation and/or other materials provided with the distribution.
-
-     3. The names of its contributors may not be used to endorse or promote
-        products derived from this software without specific prior written
-        permission.
-
-   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
-   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
-   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
-   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
-   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
-   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
-   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-
-
-   Any feedback is very welcome.
-   http://www.math.sci.hiroshima-u.ac.jp/~m-mat/MT/emt.html
-   email: m-mat @ math.sci.hiroshima-u.ac.jp (remove space)
-*/
+//
+// Created by draia on 27/01/2022.
+//
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
+#include "../TP3/mt.h"
+#include "../TP3/rng.h"
 
-/* Period parameters */
-#define N 624
-#define M 397
-#define MATRIX_A 0x9908b0dfUL   /* constant vector a */
-#define UPPER_MASK 0x80000000UL /* most significant w-r bits */
-#define LOWER_MASK 0x7fffffffUL /* least significant r bits */
-
-static unsigned long mt[N]; /* the array for the state vector  */
-static int           mti = N + 1; /* mti==N+1 means mt[N] is not initialized */
-
-/* initializes mt[N] with a seed */
-void init_genrand(unsigned long s)
-{
-    mt[0] = s & 0xffffffffUL;
-    for (mti = 1; mti < N; mti++)
-    {
-        mt[mti] =
-                (1812433253UL * (mt[mti - 1] ^ (mt[mti - 1] >> 30)) + mti);
-        /* See Knuth TAOCP Vol2. 3rd Ed. P.106 for multiplier. */
-        /* In the previous versions, MSBs of the seed affect   */
-        /* only MSBs of the array mt[].                        */
-        /* 2002/01/09 modified by Makoto Matsumoto             */
-        mt[mti] &= 0xffffffffUL;
-        /* for >32 bit machines */
-    }
-}
-
-/* initialize by an array with array-length */
-/* init_key is the array for initializing keys */
-/* key_length is its length */
-/* slight change for C++, 2004/2/26 */
-void init_by_array(unsigned long init_key[], int key_length)
-{
-    int i, j, k;
-    init_genrand(19650218UL);
-    i = 1;
-    j = 0;
-    k = (N > key_length ? N : key_length);
-    for (; k; k--)
-    {
-        mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 30)) * 1664525UL))
-                + init_key[j] + j; /* non linear */
-        mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
-        i++;
-        j++;
-        if (i >= N)
-        {
-            mt[0] = mt[N - 1];
-            i = 1;
-        }
-        if (j >= key_length) j = 0;
-    }
-    for (k = N - 1; k; k--)
-    {
-        mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 30)) * 1566083941UL))
-                - i; /* non linear */
-        mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
-        i++;
-        if (i >= N)
-        {
-            mt[0] = mt[N - 1];
-            i = 1;
-        }
-    }
-
-    mt[0] = 0x80000000UL; /* MSB is 1; assuring non-zero initial array */
-}
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(MT_NO_SIMD)
+#define BM_X86_SIMD
+#include <immintrin.h>
+#endif
 
-/* generates a random number on [0,0xffffffff]-interval */
-unsigned long genrand_int32(void)
-{
-    unsigned long        y;
-    static unsigned long mag01[2] = {0x0UL, MATRIX_A};
-    /* mag01[x] = x * MATRIX_A  for x=0,1 */
+// let me have this!
+#define TAU (2*M_PI)
+#define DEBUG printf("file %s; line %d\n", __FILE__, __LINE__);
+#define FAIL_OUT DEBUG exit(EXIT_FAILURE);
+#define MALLOC_FAIL printf("!_malloc failed_!\n"); FAIL_OUT
 
-    if (mti >= N)
-    { /* generate N words at one time */
-        int kk;
+// Ziggurat of the normal density (Marsaglia & Tsang, 2000): 128 layers of equal area ZIG_V, the base one ending at ZIG_R
+#define ZIG_LAYERS 128
+#define ZIG_R 3.442619855899
+#define ZIG_V 9.91256303526217e-3
 
-        if (mti == N + 1)   /* if init_genrand() has not been called, */
-            init_genrand(5489UL); /* a default initial seed is used */
+static double zigX[ZIG_LAYERS + 1]; // right edge of each layer, zigX[ZIG_LAYERS] = 0 being the top
+static double zigF[ZIG_LAYERS + 1]; // exp(-x^2 / 2) there
+static double zigK[ZIG_LAYERS];     // zigX[i + 1] / zigX[i]: below it, a point of layer i is under the curve
+static int    zigReady = 0;
 
-        for (kk = 0; kk < N - M; kk++)
-        {
-            y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
-            mt[kk] = mt[kk + M] ^ (y >> 1) ^ mag01[y & 0x1UL];
-        }
-        for (; kk < N - 1; kk++)
-        {
-            y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
-            mt[kk] = mt[kk + (M - N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
-        }
-        y = (mt[N - 1] & UPPER_MASK) | (mt[0] & LOWER_MASK);
-        mt[N - 1] = mt[M - 1] ^ (y >> 1) ^ mag01[y & 0x1UL];
+// Ziggurat of the exponential density (Marsaglia & Tsang, 2000): 256 layers of equal area ZIGE_V, the base one ending at ZIGE_R
+#define ZIGE_LAYERS 256
+#define ZIGE_R 7.69711747013104972
+#define ZIGE_V 3.949659822581572e-3
 
-        mti = 0;
-    }
+static double zigeX[ZIGE_LAYERS + 1]; // as zigX, for exp(-x)
+static double zigeF[ZIGE_LAYERS + 1];
+static double zigeK[ZIGE_LAYERS];
+static int    zigeReady = 0;
 
-    y = mt[mti++];
+// boxMuller_fill(): pairs per batch of uniforms, and kernels
+#define BM_BATCH 512
+#define BM_SIMD_SCALAR 0
+#define BM_SIMD_AVX2   1
 
-    /* Tempering */
-    y ^= (y >> 11);
-    y ^= (y << 7) & 0x9d2c5680UL;
-    y ^= (y << 15) & 0xefc60000UL;
-    y ^= (y >> 18);
+static int bmSimdMax = BM_SIMD_AVX2; // lowered by boxMuller_simd_select()
 
-    return y;
-}
+// aliasFill(): draws per batch of uniforms
+#define ALIAS_BATCH 512
 
-/* generates a random number on [0,1]-real-interval */
-double genrand_real1(void)
+/* Walker's alias table (Vose's construction): column k keeps category k with probability thr[k] / 2^32, else gives
+ * alias[k]; each of the size columns is drawn with probability 1 / size */
+typedef struct alias_table
 {
-    return genrand_int32() * (1.0 / 4294967295.0);
-    /* divided by 2^32-1 */
-}
+    int      size;
+    uint64_t *thr;   // in [0, 2^32], 2^32 for a column that is all its own
+    int      *alias;
+} alias_table;
 
-/* generates a random number on [0,1)-real-interval */
-double genrand_real2(void)
-{
-    return genrand_int32() * (1.0 / 4294967296.0);
-    /* divided by 2^32 */
-}
+// guideFill(): draws per batch of uniforms
+#define GUIDE_BATCH 512
 
-/* generates a random number on (0,1)-real-interval */
-double genrand_real3(void)
+/* Chen & Asau's guide table over a CDF: guide[j] is the first category whose CDF exceeds j / guides, guides being a
+ * power of 2 so that u * guides and j / guides are exact; the category of u lies in [guide[j], guide[j + 1]] */
+typedef struct guide_table
 {
-    return (((double) genrand_int32()) + 0.5) * (1.0 / 4294967296.0);
-    /* divided by 2^32 */
-}
-
-/* These real versions are due to Isaku Wada, 2002/01/09 added */
-///////////////////////////////////////////////////////////////////////////////////////////////////////
-//
-// Created by draia on 27/01/2022.
-//
-
-#include <math.h>
-
-// let me have this!
-#define TAU (2*M_PI)
-#define DEBUG printf("file %s; line %d\n", __FILE__, __LINE__);
-#define FAIL_OUT DEBUG exit(EXIT_FAILURE);
-#define MALLOC_FAIL printf("!_malloc failed_!\n"); FAIL_OUT
+    int    size;
+    int    guides;
+    double *cdf;   // size entries, the last one exactly 1
+    int    *guide; // guides + 1 entries, guide[guides] = last
+    int    last;   // last category with observations, that of u = 1
+} guide_table;
 
 /*-------------------------------------------------------------------------------*/
 /*-----------------------------    ANNEXES    -----------------------------------*/
@@ -301,6 +184,335 @@ void printArrMsg_f(char *msg, double *arr, int n)
     }
 }
 
+/**
+ * zigInit
+ * fills the normal Ziggurat tables, once: layer i >= 1 is the rectangle [0, zigX[i]] x [zigF[i], zigF[i + 1]],
+ * of area ZIG_V, and the base layer [0, zigX[0]] x [0, zigF[1]] has that area too, the tail past ZIG_R included
+ */
+void zigInit(void)
+{
+    zigX[0]          = ZIG_V / exp(-0.5 * ZIG_R * ZIG_R);
+    zigX[1]          = ZIG_R;
+    zigX[ZIG_LAYERS] = 0.0;
+    for (int i = 2; i < ZIG_LAYERS; i++)
+    {
+        zigX[i] = sqrt(-2 * log(ZIG_V / zigX[i - 1] + exp(-0.5 * zigX[i - 1] * zigX[i - 1])));
+    }
+    for (int i = 0; i <= ZIG_LAYERS; i++)
+    {
+        zigF[i] = exp(-0.5 * zigX[i] * zigX[i]);
+    }
+    for (int i = 0; i < ZIG_LAYERS; i++)
+    {
+        zigK[i] = zigX[i + 1] / zigX[i];
+    }
+    zigReady = 1;
+}
+
+/**
+ * zigNormal
+ * standard normal random number by the Ziggurat method: one 64-bit draw picks a layer (low 7 bits), a sign (bit 7)
+ * and a uniform (top 53 bits, apart from the others); 97% of the time, the point is under the curve, and the
+ * number is that uniform times the layer width. Otherwise, the wedge (or, in the base layer, the tail) is sampled
+ * exactly, with an exp() or log()
+ * @return said number
+ */
+double zigNormal(void)
+{
+    uint64_t u;
+    int      i;
+    double   x, y;
+
+    if (!zigReady) zigInit();
+    for (;;)
+    {
+        u = rng_u64();
+        i = (int) (u & (ZIG_LAYERS - 1));
+        x = (double) (u >> 11) * (1.0 / 9007199254740992.0); // [0, 1[
+        if (x < zigK[i])
+        {
+            x *= zigX[i];
+            return (u & ZIG_LAYERS) ? -x : x;
+        }
+        x *= zigX[i];
+        if (i == 0)
+        {
+            // tail past ZIG_R (Marsaglia, 1964)
+            do
+            {
+                x = -log(rng_real3()) / ZIG_R;
+                y = -log(rng_real3());
+            } while (2 * y < x * x);
+            x += ZIG_R;
+        } else if (zigF[i] + rng_real2() * (zigF[i + 1] - zigF[i]) >= exp(-0.5 * x * x))
+        {
+            continue; // in the rectangle, above the curve: another draw
+        }
+        return (u & ZIG_LAYERS) ? -x : x;
+    }
+}
+
+/**
+ * zigExpInit
+ * fills the exponential Ziggurat tables, once, as zigInit() does for the normal ones
+ */
+void zigExpInit(void)
+{
+    zigeX[0]           = ZIGE_V / exp(-ZIGE_R);
+    zigeX[1]           = ZIGE_R;
+    zigeX[ZIGE_LAYERS] = 0.0;
+    for (int i = 2; i < ZIGE_LAYERS; i++)
+    {
+        zigeX[i] = -log(ZIGE_V / zigeX[i - 1] + exp(-zigeX[i - 1]));
+    }
+    for (int i = 0; i <= ZIGE_LAYERS; i++)
+    {
+        zigeF[i] = exp(-zigeX[i]);
+    }
+    for (int i = 0; i < ZIGE_LAYERS; i++)
+    {
+        zigeK[i] = zigeX[i + 1] / zigeX[i];
+    }
+    zigeReady = 1;
+}
+
+/**
+ * zigExp
+ * exponential random number of mean 1 by the Ziggurat method: one 64-bit draw picks a layer (low 8 bits) and
+ * a uniform (top 53 bits); 98% of the time, that uniform times the layer width is the number. Otherwise, an exp()
+ * for the wedge or, in the base layer, a log() for the tail: past ZIGE_R, it is ZIGE_R plus an exponential again
+ * @return said number
+ */
+double zigExp(void)
+{
+    uint64_t u;
+    int      i;
+    double   x;
+
+    if (!zigeReady) zigExpInit();
+    for (;;)
+    {
+        u = rng_u64();
+        i = (int) (u & (ZIGE_LAYERS - 1));
+        x = (double) (u >> 11) * (1.0 / 9007199254740992.0); // [0, 1[
+        if (x < zigeK[i]) return x * zigeX[i];
+        x *= zigeX[i];
+        if (i == 0) return ZIGE_R - log(rng_real3()); // the tail, memoryless
+        if (zigeF[i] + rng_real2() * (zigeF[i + 1] - zigeF[i]) < exp(-x)) return x;
+    }
+}
+
+/**
+ * bmFillScalar
+ * Box-Muller on 32-bit words, libm's log, sqrt, cos and sin: the reference for bmFillAvx2()
+ * <br>pair k comes from words 2k and 2k + 1, as u = (w + 0.5) / 2^32, in ]0, 1[
+ * @param w 2 * pairs words
+ * @param out 2 * pairs normal numbers, cos then sin
+ * @param pairs number of pairs
+ * @param inMean said mean
+ * @param inSigma said sigma
+ */
+void bmFillScalar(const uint32_t *w, double *out, size_t pairs, double inMean, double inSigma)
+{
+    double u1, u2, mag;
+
+    for (size_t k = 0; k < pairs; k++)
+    {
+        u1  = (w[2 * k] + 0.5) * (1.0 / 4294967296.0);
+        u2  = (w[2 * k + 1] + 0.5) * (1.0 / 4294967296.0);
+        mag = inSigma * sqrt(-2 * log(u1));
+        out[2 * k]     = mag * cos(TAU * u2) + inMean;
+        out[2 * k + 1] = mag * sin(TAU * u2) + inMean;
+    }
+}
+
+#ifdef BM_X86_SIMD
+
+/*
+ * log(x), x > 0 and normal: x = m 2^e, m in [sqrt(1/2), sqrt(2)[, and log(m) = 2 atanh(s), s = (m - 1) / (m + 1),
+ * |s| <= 0.172, by its series up to s^19 (next term < 2e-17 relative); e log(2) in two parts, so that it is exact
+ */
+__attribute__((target("avx2,fma")))
+static __m256d bmLog(__m256d x)
+{
+    const __m256d one   = _mm256_set1_pd(1.0);
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0); // 2^52, to turn small integers into doubles
+    __m256i       bits  = _mm256_castpd_si256(x);
+    __m256i       ebits = _mm256_srli_epi64(bits, 52);
+    __m256d       m     = _mm256_castsi256_pd(_mm256_or_si256(
+            _mm256_and_si256(bits, _mm256_set1_epi64x(0x000fffffffffffffLL)),
+            _mm256_set1_epi64x(0x3ff0000000000000LL))); // [1, 2[
+    __m256d       e     = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(ebits, _mm256_castpd_si256(magic))),
+                                        _mm256_add_pd(magic, _mm256_set1_pd(1023.0)));
+    __m256d       big   = _mm256_cmp_pd(m, _mm256_set1_pd(M_SQRT2), _CMP_GE_OQ);
+    __m256d       s, z, p;
+
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+    e = _mm256_add_pd(e, _mm256_and_pd(big, one));
+    s = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+    z = _mm256_mul_pd(s, s);
+    p = _mm256_set1_pd(2.0 / 19);
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(2.0 / 17));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(2.0 / 15));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(2.0 / 13));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(2.0 / 11));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(2.0 / 9));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(2.0 / 7));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(2.0 / 5));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(2.0 / 3));
+    p = _mm256_mul_pd(_mm256_mul_pd(p, z), s); // 2 atanh(s) - 2s
+    p = _mm256_fmadd_pd(e, _mm256_set1_pd(1.9082149292705877e-10), p); // log(2) - its first 32 bits
+    p = _mm256_add_pd(p, _mm256_add_pd(s, s));
+    return _mm256_fmadd_pd(e, _mm256_set1_pd(6.93147180369123816490e-01), p); // first 32 bits of log(2)
+}
+
+/*
+ * cos(2 pi u) and sin(2 pi u), u in [0, 1[: with v the nearest integer to 4u, 4u - v is exact, so the reduced
+ * angle r = (4u - v) pi / 2, in [-pi/4, pi/4], is off by half an ulp at most; Taylor series up to r^17 and r^18
+ * (next terms < 1e-19), then the quadrant v mod 4 swaps and flips them
+ */
+__attribute__((target("avx2,fma")))
+static void bmCosSin(__m256d u, __m256d *c, __m256d *s)
+{
+    __m256d t = _mm256_mul_pd(u, _mm256_set1_pd(4.0));
+    __m256d v = _mm256_round_pd(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_mul_pd(_mm256_sub_pd(t, v), _mm256_set1_pd(M_PI_2));
+    __m256d z = _mm256_mul_pd(r, r);
+    __m256d ps, pc, swap, cNeg, sNeg, q, tmp;
+
+    ps = _mm256_set1_pd(1.0 / 355687428096000.0); // 1 / 17!
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(-1.0 / 1307674368000.0));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(1.0 / 6227020800.0));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(-1.0 / 39916800.0));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(1.0 / 362880.0));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(-1.0 / 5040.0));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(1.0 / 120.0));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(-1.0 / 6.0));
+    ps = _mm256_fmadd_pd(_mm256_mul_pd(ps, z), r, r);
+    pc = _mm256_set1_pd(-1.0 / 6402373705728000.0); // -1 / 18!
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(1.0 / 20922789888000.0));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(-1.0 / 87178291200.0));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(1.0 / 479001600.0));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(-1.0 / 3628800.0));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(1.0 / 40320.0));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(-1.0 / 720.0));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(1.0 / 24.0));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(-0.5));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(1.0));
+
+    // quadrant: v in {0, 1, 2, 3, 4}, 4 being 0
+    q    = _mm256_andnot_pd(_mm256_cmp_pd(v, _mm256_set1_pd(4.0), _CMP_EQ_OQ), v);
+    swap = _mm256_or_pd(_mm256_cmp_pd(q, _mm256_set1_pd(1.0), _CMP_EQ_OQ),
+                        _mm256_cmp_pd(q, _mm256_set1_pd(3.0), _CMP_EQ_OQ));
+    cNeg = _mm256_or_pd(_mm256_cmp_pd(q, _mm256_set1_pd(1.0), _CMP_EQ_OQ),
+                        _mm256_cmp_pd(q, _mm256_set1_pd(2.0), _CMP_EQ_OQ));
+    sNeg = _mm256_cmp_pd(q, _mm256_set1_pd(2.0), _CMP_GE_OQ);
+    tmp  = _mm256_blendv_pd(pc, ps, swap);
+    ps   = _mm256_blendv_pd(ps, pc, swap);
+    pc   = tmp;
+    *c   = _mm256_xor_pd(pc, _mm256_and_pd(cNeg, _mm256_set1_pd(-0.0)));
+    *s   = _mm256_xor_pd(ps, _mm256_and_pd(sNeg, _mm256_set1_pd(-0.0)));
+}
+
+/* bmFillScalar(), 4 pairs per step, with bmLog() and bmCosSin() */
+__attribute__((target("avx2,fma")))
+static void bmFillAvx2(const uint32_t *w, double *out, size_t pairs, double inMean, double inSigma)
+{
+    const __m256i evenOdd = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i flip    = _mm256_set1_epi32((int) 0x80000000);
+    const __m256d scale   = _mm256_set1_pd(1.0 / 4294967296.0);
+    const __m256d offset  = _mm256_set1_pd(2147483648.0 + 0.5); // undoes the sign flip, then centers
+    const __m256d mean    = _mm256_set1_pd(inMean), sigma = _mm256_set1_pd(inSigma);
+    __m256i       words;
+    __m256d       u1, u2, mag, c, s, x1, x2, lo, hi;
+    size_t        k       = 0;
+
+    for (; k + 4 <= pairs; k += 4)
+    {
+        words = _mm256_xor_si256(_mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *) (w + 2 * k)),
+                                                              evenOdd), flip);
+        u1    = _mm256_mul_pd(_mm256_add_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(words)), offset), scale);
+        u2    = _mm256_mul_pd(_mm256_add_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(words, 1)), offset), scale);
+        mag   = _mm256_mul_pd(sigma, _mm256_sqrt_pd(_mm256_mul_pd(_mm256_set1_pd(-2.0), bmLog(u1))));
+        bmCosSin(u2, &c, &s);
+        x1 = _mm256_fmadd_pd(mag, c, mean);
+        x2 = _mm256_fmadd_pd(mag, s, mean);
+        lo = _mm256_unpacklo_pd(x1, x2); // x1[0] x2[0] x1[2] x2[2]
+        hi = _mm256_unpackhi_pd(x1, x2); // x1[1] x2[1] x1[3] x2[3]
+        _mm256_storeu_pd(out + 2 * k, _mm256_permute2f128_pd(lo, hi, 0x20));
+        _mm256_storeu_pd(out + 2 * k + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+    }
+    bmFillScalar(w + 2 * k, out + 2 * k, pairs - k, inMean, inSigma);
+}
+
+#endif // BM_X86_SIMD
+
+/**
+ * bmSimdLevel
+ * @return the kernel boxMuller_fill() uses: the best one the CPU supports, up to bmSimdMax
+ */
+int bmSimdLevel(void)
+{
+#ifdef BM_X86_SIMD
+    if (bmSimdMax >= BM_SIMD_AVX2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return BM_SIMD_AVX2;
+    }
+#endif
+    return BM_SIMD_SCALAR;
+}
+
+/**
+ * aliasPick
+ * the alias method on two 32-bit words: one picks the column, the other is compared to its threshold
+ * <br>no branch to mispredict, the compare becoming a conditional move
+ * @param t alias table
+ * @param wCol word picking the column, as (wCol * size) / 2^32
+ * @param wThr word compared to the threshold
+ * @return a category, in [0, size[
+ */
+static inline int aliasPick(const alias_table *t, uint32_t wCol, uint32_t wThr)
+{
+    int col = (int) (((uint64_t) wCol * (uint64_t) t->size) >> 32);
+
+    return (wThr < t->thr[col]) ? col : t->alias[col];
+}
+
+/**
+ * elapsedNs
+ * time between two clock_gettime() readings
+ * @param t0 first reading
+ * @param t1 second reading
+ * @return said time, in nanoseconds
+ */
+double elapsedNs(const struct timespec *t0, const struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+/**
+ * guideSearch
+ * finds the first category in [inLo, inHi] whose CDF exceeds u, by a binary search of a fixed number of steps for a
+ * given width, each one a conditional move rather than a branch to mispredict
+ * @param t guide table
+ * @param u said uniform
+ * @param inLo first candidate
+ * @param inHi last candidate, its CDF exceeding u
+ * @return said category
+ */
+static inline int guideSearch(const guide_table *t, double u, int inLo, int inHi)
+{
+    int lo = inLo, len = inHi - inLo + 1, half;
+
+    while (len > 1)
+    {
+        half = len / 2;
+        lo   = (t->cdf[lo + half - 1] <= u) ? lo + half : lo;
+        len -= half;
+    }
+    return lo;
+}
+
 /*-------------------------------------------------------------------------------*/
 /*-----------------------------   BUSINESS    -----------------------------------*/
 /*-------------------------------------------------------------------------------*/
@@ -314,14 +526,16 @@ void printArrMsg_f(char *msg, double *arr, int n)
  */
 double uniform(double inLo, double inHi)
 {
-    return inLo + genrand_real1() * (inHi - inLo);
+    return inLo + rng_real1() * (inHi - inLo);
 }
 
 /**
  * cdf
- * finds the cumulative distribution function from basic observation data
+ * finds the cumulative distribution function from basic observation data, in one pass
+ * <br>the prefix sums are those of the counts, in integers, so exact: each entry is the nearest double to its true
+ * value, the entries never decrease, and the last one is exactly 1 (which a sum of rounded probabilities is not)
  * @param inSize size of observation data array, strictly positive
- * @param inObs said array, of ints, non null
+ * @param inObs said array, of non-negative ints, non null, not all 0
  * @return an array of doubles, CDF
  */
 double *cdf(int inSize, const int *inObs)
@@ -332,35 +546,295 @@ double *cdf(int inSize, const int *inObs)
         FAIL_OUT
     }
 
-    int    i, j;
-    int    ttl  = 0;
-    double *pdf = mkArr(inSize);
+    int       i;
+    long long ttl = 0, cuml = 0;
+    double    *cdf;
 
     // finding sample size
     for (i = 0; i < inSize; i++)
     {
+        if (inObs[i] < 0)
+        {
+            printf("cdf: observation %d is negative (%d)\n", i, inObs[i]);
+            FAIL_OUT
+        }
         ttl += inObs[i];
     }
+    if (ttl == 0)
+    {
+        printf("cdf: please provide at least one observation\n");
+        FAIL_OUT
+    }
 
-    // 3.b.a producing probability distribution function
+    // 3.b producing cumulative distribution function
+    cdf = mkArr(inSize);
     for (i = 0; i < inSize; i++)
     {
-        pdf[i] = (double) inObs[i] / ttl;
+        cuml += inObs[i];
+        cdf[i] = (double) cuml / ttl;
     }
-    printArrMsg_f("PDF:", pdf, 6);
+    return cdf;
+}
 
-    double *cdf = mkArr(inSize);
+/**
+ * aliasTable
+ * builds the alias table of the empirical distribution of basic observation data, in O(inSize) (Vose's method)
+ * <br>in integers, weight k being inObs[k] * inSize against a column's inTotal: the table's probabilities are those of
+ * the data to the nearest 2^-32 of a column, with no rounding drift over tens of thousands of categories
+ * @param inSize size of observation data array, strictly positive
+ * @param inObs said array, of non-negative ints, non null, not all 0
+ * @return said table, to be freed with freeAlias()
+ */
+alias_table *aliasTable(int inSize, const int *inObs)
+{
+    if ((inSize < 1) || (inObs == NULL))
+    {
+        printf("aliasTable: please provide a non-null array, and a strictly positive size for it\n");
+        FAIL_OUT
+    }
+
+    int         i, s, l, nSmall = 0, nLarge = 0;
+    long long   ttl = 0;
+    long long   *weight;
+    int         *small, *large;
+    alias_table *res;
 
-    // 3.b.b producing cumulative distribution function
     for (i = 0; i < inSize; i++)
     {
-        for (j = 0; j <= i; j++)
+        if (inObs[i] < 0)
         {
-            cdf[i] += pdf[j];
+            printf("aliasTable: observation %d is negative (%d)\n", i, inObs[i]);
+            FAIL_OUT
         }
+        ttl += inObs[i];
     }
-    free(pdf);
-    return cdf;
+    if (ttl == 0)
+    {
+        printf("aliasTable: please provide at least one observation\n");
+        FAIL_OUT
+    }
+
+    res    = malloc(sizeof(alias_table));
+    weight = malloc(sizeof(long long) * inSize);
+    small  = malloc(sizeof(int) * inSize);
+    large  = malloc(sizeof(int) * inSize);
+    if (res == NULL || weight == NULL || small == NULL || large == NULL)
+    {
+        MALLOC_FAIL
+    }
+    res->size  = inSize;
+    res->thr   = malloc(sizeof(uint64_t) * inSize);
+    res->alias = mkArr_int(inSize);
+    if (res->thr == NULL)
+    {
+        MALLOC_FAIL
+    }
+
+    // a column holds ttl: categories under it (small) are topped up by categories over it (large)
+    for (i = 0; i < inSize; i++)
+    {
+        weight[i] = (long long) inObs[i] * inSize;
+        if (weight[i] < ttl) small[nSmall++] = i;
+        else large[nLarge++] = i;
+    }
+    while (nSmall > 0 && nLarge > 0)
+    {
+        s = small[--nSmall];
+        l = large[nLarge - 1];
+        res->thr[s]   = (uint64_t) llround(ldexp((double) weight[s] / ttl, 32));
+        res->alias[s] = l;
+        weight[l] -= ttl - weight[s];
+        if (weight[l] < ttl)
+        {
+            nLarge--;
+            small[nSmall++] = l;
+        }
+    }
+    // what is left is full, exactly in integers
+    while (nLarge > 0)
+    {
+        l = large[--nLarge];
+        res->thr[l]   = (uint64_t) 1 << 32;
+        res->alias[l] = l;
+    }
+    while (nSmall > 0) // only if weights had not added up, which integers rule out: kept for safety
+    {
+        s = small[--nSmall];
+        res->thr[s]   = (uint64_t) 1 << 32;
+        res->alias[s] = s;
+    }
+
+    free(weight);
+    free(small);
+    free(large);
+    return res;
+}
+
+/**
+ * aliasDraw
+ * draws a category from an alias table: one 64-bit draw, one multiply, one compare, whatever the number of categories
+ * @param t said table
+ * @return said category, in [0, t->size[
+ */
+int aliasDraw(const alias_table *t)
+{
+    uint64_t x = rng_u64();
+
+    return aliasPick(t, (uint32_t) (x >> 32), (uint32_t) x);
+}
+
+/**
+ * aliasFill
+ * fills an array with categories drawn from an alias table, on uniforms drawn in bulk (rng_fill_u32()), ALIAS_BATCH
+ * draws at a time
+ * <br>same distribution as aliasDraw(), not the same categories: the words come in another order
+ * @param t said table
+ * @param out n categories
+ * @param n number of categories
+ */
+void aliasFill(const alias_table *t, int *out, size_t n)
+{
+    uint32_t w[2 * ALIAS_BATCH];
+    size_t   done = 0, p;
+
+    while (done < n)
+    {
+        p = (n - done < ALIAS_BATCH) ? n - done : ALIAS_BATCH;
+        rng_fill_u32(w, 2 * p);
+        for (size_t k = 0; k < p; k++)
+        {
+            out[done + k] = aliasPick(t, w[2 * k], w[2 * k + 1]);
+        }
+        done += p;
+    }
+}
+
+/**
+ * freeAlias
+ * frees an alias table
+ * @param t said table
+ */
+void freeAlias(alias_table *t)
+{
+    free(t->thr);
+    free(t->alias);
+    free(t);
+}
+
+/**
+ * guideTable
+ * builds the guide table of the empirical distribution of basic observation data, in O(inSize): its CDF (see cdf()),
+ * and the smallest power of 2 of guides not under inSize, so that a lookup checks about 2 categories on average
+ * @param inSize size of observation data array, strictly positive
+ * @param inObs said array, of non-negative ints, non null, not all 0
+ * @return said table, to be freed with freeGuide()
+ */
+guide_table *guideTable(int inSize, const int *inObs)
+{
+    int         i = 0, logGuides = 0;
+    guide_table *res;
+
+    res = malloc(sizeof(guide_table));
+    if (res == NULL)
+    {
+        MALLOC_FAIL
+    }
+    res->size = inSize;
+    res->cdf  = cdf(inSize, inObs);
+    while ((1 << logGuides) < inSize) logGuides++;
+    res->guides = 1 << logGuides;
+    res->guide  = mkArr_int(res->guides + 1);
+
+    // one walk along the CDF: j / guides is exact, and cdf[inSize - 1] = 1 stops it
+    for (int j = 0; j < res->guides; j++)
+    {
+        while (res->cdf[i] <= ldexp(j, -logGuides)) i++;
+        res->guide[j] = i;
+    }
+    // the CDF reaches 1 exactly on the last category with observations, the empty ones after it stay there
+    for (res->last = inSize - 1; res->last > 0 && inObs[res->last] == 0; res->last--);
+    res->guide[res->guides] = res->last;
+    return res;
+}
+
+/**
+ * guidePick
+ * inverts the CDF of a guide table at a given uniform: the guide of u, then guideSearch() between it and the next one
+ * <br>monotonic: a larger u never gives a smaller category, so that common random numbers and quasi-random points
+ * keep their order through it; the same category as a linear scan for the first CDF entry over u
+ * @param t said table
+ * @param u said uniform, in [0, 1]
+ * @return said category, in [0, t->size[, never one of no observation
+ */
+int guidePick(const guide_table *t, double u)
+{
+    int j = (int) (u * t->guides);
+
+    if (j >= t->guides) return t->last; // u = 1: no CDF entry exceeds it
+    return guideSearch(t, u, t->guide[j], t->guide[j + 1]);
+}
+
+/**
+ * guideDraw
+ * draws a category from a guide table, on one rng_real2()
+ * @param t said table
+ * @return said category, in [0, t->size[
+ */
+int guideDraw(const guide_table *t)
+{
+    return guidePick(t, rng_real2());
+}
+
+/**
+ * guideMap
+ * inverts the CDF of a guide table at each of the given uniforms (guidePick()), quasi-random points say
+ * @param t said table
+ * @param u n uniforms, in [0, 1]
+ * @param out n categories, out[i] being that of u[i]
+ * @param n number of uniforms
+ */
+void guideMap(const guide_table *t, const double *u, int *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = guidePick(t, u[i]);
+    }
+}
+
+/**
+ * guideFill
+ * fills an array with categories drawn from a guide table, on uniforms drawn in bulk (rng_fill_real2()), GUIDE_BATCH
+ * draws at a time
+ * <br>real2, not real1: inversion expects u on [0, 1[, and real1 can return exactly 1.0, which no CDF entry exceeds;
+ * guidePick() only catches it as an edge case (t->last), real2 never draws it
+ * @param t said table
+ * @param out n categories
+ * @param n number of categories
+ */
+void guideFill(const guide_table *t, int *out, size_t n)
+{
+    double u[GUIDE_BATCH];
+    size_t done = 0, p;
+
+    while (done < n)
+    {
+        p = (n - done < GUIDE_BATCH) ? n - done : GUIDE_BATCH;
+        rng_fill_real2(u, p);
+        guideMap(t, u, out + done, p);
+        done += p;
+    }
+}
+
+/**
+ * freeGuide
+ * frees a guide table
+ * @param t said table
+ */
+void freeGuide(guide_table *t)
+{
+    free(t->cdf);
+    free(t->guide);
+    free(t);
 }
 
 /**
@@ -371,7 +845,18 @@ double *cdf(int inSize, const int *inObs)
  */
 double negExp(double inMean)
 {
-    return (-inMean * log(1 - genrand_real2()));
+    return (-inMean * log(1 - rng_real2()));
+}
+
+/**
+ * negExpZig
+ * negExp(), by the Ziggurat method (see zigExp()): same distribution, but mostly without a log()
+ * @param inMean a desired mean
+ * @return said random number
+ */
+double negExpZig(double inMean)
+{
+    return inMean * zigExp();
 }
 
 /**
@@ -387,7 +872,7 @@ int ndn(int inThrows, int inSides)
 
     for (int i = 0; i < inThrows; i++)
     {
-        res += (int) (1 + genrand_real1() * inSides);
+        res += (int) (1 + rng_real1() * inSides);
     }
     return res;
 }
@@ -404,18 +889,87 @@ void boxMuller(double *inX1, double *inX2, double inMean, double inSigma)
 {
     //with some help from https://en.wikipedia.org/wiki/Box%E2%80%93Muller_transform
 
-    double r1  = genrand_real2();
-    double r2  = genrand_real2();
+    double r1  = rng_real2();
+    double r2  = rng_real2();
     double mag = inSigma * sqrt((-2 * log(r1)));
     *inX1 = mag * cos(TAU * r2) + inMean;
     *inX2 = mag * sin(TAU * r2) + inMean;
 }
 
+/**
+ * boxMuller_simd_select
+ * caps the kernel boxMuller_fill() uses, to compare them
+ * @param inMax BM_SIMD_SCALAR, BM_SIMD_AVX2
+ * @return the kernel now in use
+ */
+int boxMuller_simd_select(int inMax)
+{
+    bmSimdMax = inMax;
+    return bmSimdLevel();
+}
+
+/**
+ * boxMuller_fill
+ * fills an array with random numbers normally distributed around a given mean according to a given sigma,
+ * by Box-Muller on uniforms drawn in bulk (rng_fill_u32()), BM_BATCH pairs at a time
+ * <br>on AVX2 with FMA, 4 pairs per step: polynomial log, cos and sin (see bmLog(), bmCosSin()), within 4e-15
+ * of the scalar kernel's libm results for sigma 1 (both within a few ulps of the exact values; the largest
+ * numbers, around 6.7, have an ulp of 8.9e-16)
+ * <br>same distribution as boxMuller(), not the same numbers: u = (w + 0.5) / 2^32 instead of genrand_real2()
+ * @param out n numbers, pair k being out[2k] (cos) and out[2k + 1] (sin)
+ * @param n number of numbers, even or not (the last sin is dropped)
+ * @param inMean said mean
+ * @param inSigma said sigma (standard deviation)
+ */
+void boxMuller_fill(double *out, size_t n, double inMean, double inSigma)
+{
+    uint32_t w[2 * BM_BATCH];
+    double   last[2];
+    size_t   pairs = n / 2, done = 0, p;
+    int      level = bmSimdLevel();
+
+    while (done < pairs)
+    {
+        p = (pairs - done < BM_BATCH) ? pairs - done : BM_BATCH;
+        rng_fill_u32(w, 2 * p);
+#ifdef BM_X86_SIMD
+        if (level == BM_SIMD_AVX2)
+        {
+            bmFillAvx2(w, out + 2 * done, p, inMean, inSigma);
+        } else
+#endif
+        {
+            bmFillScalar(w, out + 2 * done, p, inMean, inSigma);
+        }
+        done += p;
+    }
+    if (n % 2)
+    {
+        rng_fill_u32(w, 2);
+        bmFillScalar(w, last, 1, inMean, inSigma);
+        out[n - 1] = last[0];
+    }
+}
+
+/**
+ * ziggurat
+ * generates a random number normally distributed around a given mean according to a given sigma, by the Ziggurat
+ * method (see zigNormal()): mostly one draw, one multiply and one compare, where boxMuller() takes two draws and
+ * a log, a sqrt, a cos and a sin for two numbers
+ * @param inMean said mean
+ * @param inSigma said sigma (standard deviation)
+ * @return said random number
+ */
+double ziggurat(double inMean, double inSigma)
+{
+    return inMean + inSigma * zigNormal();
+}
+
 /*-------------------------------------------------------------------------------*/
 /*-----------------------------     TESTS     -----------------------------------*/
 /*-------------------------------------------------------------------------------*/
 
-int main(void)
+int main(int argc, char **argv)
 {
     // init and ### 1 ### by M.M.
     int           i, j, k;
@@ -440,6 +994,8 @@ int main(void)
     }
     // making sure that it checks out compared to ../matsumoto/mt19937ar.out
 
+    rng_use_args(argc, argv); // the rest runs on any generator, mt19937 by default
+
     printf("########### 2 ###########\n");
 
     printf("after 1000000 outputs of uniform(); expected mean = -16.25\n");
@@ -482,7 +1038,7 @@ int main(void)
         printf("sample size = %d\n", i);
         for (j = 0; j < i; j++)
         {
-            rand3a = genrand_real1();
+            rand3a = rng_real1();
             if (rand3a < 0.5) a++;
             else if (rand3a < 0.65) b++;
             else c++;
@@ -494,27 +1050,17 @@ int main(void)
     }
 
     printf("##### 3.b #####\n");
-    int    obs3b[]      = {100, 400, 600, 400, 100, 200};
-    double *cdf3b       = cdf(6, obs3b);
-    double rand3b;
-    double testBins3[6] = {0.0};
+    int         obs3b[]      = {100, 400, 600, 400, 100, 200};
+    double      *cdf3b       = cdf(6, obs3b);
+    alias_table *alias3b     = aliasTable(6, obs3b);
+    double      testBins3[6] = {0.0};
     printArrMsg_f("CDF:", cdf3b, 6);
 
-    for (i       = 1000; i <= 1000000; i *= 1000)
+    for (i = 1000; i <= 1000000; i *= 1000)
     {
         for (j = 0; j < i; j++)
         {
-            rand3b = genrand_real1();
-            {
-                for (k = 0; k < 6; k++)
-                {
-                    if (rand3b < cdf3b[k])
-                    {
-                        testBins3[k] += 1;
-                        break;
-                    }
-                }
-            }
+            testBins3[aliasDraw(alias3b)] += 1;
         }
         for (j = 0; j < 6; j++)
         {
@@ -523,7 +1069,116 @@ int main(void)
         printf("sample size = %d: ", i);
         printArrMsg_f("DED_%:", testBins3, 6);
     }
+    freeAlias(alias3b);
     free(cdf3b);
+
+    // a real-sized empirical distribution: counts 1 to 1000 over 50000 categories, one in ten empty, the last one too
+    int         size3c  = 50000, draws3c = 5000000, full3c = 0, empty3c, last3c = 0, m;
+    int         *obs3c  = mkArr_int(size3c), *got3c = mkArr_int(size3c), *out3c = mkArr_int(draws3c);
+    long long   ttl3c   = 0;
+    double      chi2_3c, expected3c;
+    alias_table *alias3c;
+    guide_table *guide3c;
+    for (j = 0; j < size3c; j++)
+    {
+        obs3c[j] = (rng_u32() % 10 == 0 || j == size3c - 1) ? 0 : 1 + (int) (rng_u32() % 1000);
+        ttl3c += obs3c[j];
+        full3c += (obs3c[j] > 0);
+        if (obs3c[j] > 0) last3c = j;
+    }
+    alias3c = aliasTable(size3c, obs3c);
+    guide3c = guideTable(size3c, obs3c);
+    for (m = 0; m < 2; m++)
+    {
+        if (m == 0) aliasFill(alias3c, out3c, draws3c);
+        else guideFill(guide3c, out3c, draws3c);
+        for (j = 0; j < size3c; j++)
+        {
+            got3c[j] = 0;
+        }
+        for (j = 0; j < draws3c; j++)
+        {
+            got3c[out3c[j]] += 1;
+        }
+        // chi-squared over the non-empty categories (expected counts of 5 and more), none drawn from the empty ones
+        chi2_3c = 0;
+        empty3c = 0;
+        for (j = 0; j < size3c; j++)
+        {
+            if (obs3c[j] == 0)
+            {
+                empty3c += got3c[j];
+                continue;
+            }
+            expected3c = (double) draws3c * obs3c[j] / ttl3c;
+            chi2_3c += (got3c[j] - expected3c) * (got3c[j] - expected3c) / expected3c;
+        }
+        printf("%s table, %d categories, %d draws: drawn from empty categories %d (expecting 0)\n",
+               m == 0 ? "alias" : "guide", size3c, draws3c, empty3c);
+        printf("chi-squared %f for %d degrees of freedom (expecting around %d, give or take %f)\n", chi2_3c, full3c - 1,
+               full3c - 1, sqrt(2.0 * (full3c - 1)));
+    }
+
+    // inversion on a sorted grid over [0, 1]: against a linear scan walked along with it, and never decreasing;
+    // u = 1 ends it, on the last non-empty category rather than the empty last one
+    double *grid3c = mkArr(draws3c);
+    int    wrong3c = 0, down3c = 0;
+    for (j = 0; j < draws3c; j++)
+    {
+        grid3c[j] = (double) j / (draws3c - 1);
+    }
+    guideMap(guide3c, grid3c, out3c, draws3c);
+    for (j = k = 0; j < draws3c; j++)
+    {
+        while (k < last3c && guide3c->cdf[k] <= grid3c[j]) k++;
+        wrong3c += (out3c[j] != k);
+        down3c += (j > 0 && out3c[j] < out3c[j - 1]);
+    }
+    printf("guide table on %d sorted uniforms: %d differ from a linear scan, %d decrease (expecting 0 and 0)\n",
+           draws3c, wrong3c, down3c);
+    printf("u = 1 gives category %d, last non-empty one %d (expecting the same)\n", out3c[draws3c - 1], last3c);
+    free(grid3c);
+
+    struct timespec t0_3, t1_3;
+    double          rand3c;
+    long            sink3 = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0_3);
+    for (j = 0; j < draws3c / 1000; j++)
+    {
+        rand3c = rng_real2();
+        for (k = 0; k < size3c - 1 && rand3c >= guide3c->cdf[k]; k++);
+        sink3 += k;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1_3);
+    printf("time per draw: linear scan %.2f ns, ", elapsedNs(&t0_3, &t1_3) / (draws3c / 1000));
+    clock_gettime(CLOCK_MONOTONIC, &t0_3);
+    for (j = 0; j < draws3c; j++)
+    {
+        sink3 += aliasDraw(alias3c);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1_3);
+    printf("aliasDraw %.2f ns, ", elapsedNs(&t0_3, &t1_3) / draws3c);
+    clock_gettime(CLOCK_MONOTONIC, &t0_3);
+    aliasFill(alias3c, out3c, draws3c);
+    clock_gettime(CLOCK_MONOTONIC, &t1_3);
+    printf("aliasFill %.2f ns, ", elapsedNs(&t0_3, &t1_3) / draws3c);
+    sink3 += out3c[0];
+    clock_gettime(CLOCK_MONOTONIC, &t0_3);
+    for (j = 0; j < draws3c; j++)
+    {
+        sink3 += guideDraw(guide3c);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1_3);
+    printf("guideDraw %.2f ns, ", elapsedNs(&t0_3, &t1_3) / draws3c);
+    clock_gettime(CLOCK_MONOTONIC, &t0_3);
+    guideFill(guide3c, out3c, draws3c);
+    clock_gettime(CLOCK_MONOTONIC, &t1_3);
+    printf("guideFill %.2f ns (sum of some: %ld)\n", elapsedNs(&t0_3, &t1_3) / draws3c, sink3 + out3c[0]);
+    freeAlias(alias3c);
+    freeGuide(guide3c);
+    free(obs3c);
+    free(got3c);
+    free(out3c);
     printf("########### 4 ###########\n");
 
     double cuml4;
@@ -561,6 +1216,55 @@ int main(void)
             printf("in box %d: %d\n", j, testBins4[j]);
         }
     }
+
+    printf("Ziggurat variant, same tests:\n");
+    for (i = 1000; i <= 1000000; i *= 1000)
+    {
+        cuml4 = 0;
+
+        for (j = 0; j < i; j++)
+        {
+            cuml4 += negExpZig(mean4);
+        }
+        printf("sample size = %d: average = %10f\n", i, cuml4 / i);
+    }
+
+    int testBins4z[22] = {0};
+    for (i = 1000; i <= 1000000; i *= 1000)
+    {
+        printf("test bins, sample size = %d\n", i);
+        for (j = 0; j < i; j++)
+        {
+            negExpRet = (int) negExpZig(11.0);
+            if (negExpRet < 21)
+            {
+                testBins4z[negExpRet] += 1;
+            } else
+            {
+                testBins4z[21] += 1;
+            }
+        }
+        for (j = 0; j < 22; j++)
+        {
+            printf("in box %d: %d\n", j, testBins4z[j]);
+        }
+    }
+
+    struct timespec t0_4, t1_4;
+    double          ns4[2];
+    for (k = 0; k < 2; k++)
+    {
+        cuml4 = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t0_4);
+        for (j = 0; j < 10000000; j++)
+        {
+            cuml4 += k == 0 ? negExp(mean4) : negExpZig(mean4);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1_4);
+        ns4[k] = elapsedNs(&t0_4, &t1_4) / 1e7;
+        printf("%s: %.2f ns per number (average of 10000000: %10f)\n", k == 0 ? "negExp" : "negExpZig", ns4[k],
+               cuml4 / 1e7);
+    }
     printf("(see report for scatter plots of these tests)\n");
 
     printf("########### 5 ###########\n");
@@ -675,6 +1379,144 @@ int main(void)
     {
         printf("in [%d, %d[: %d\n", j, j + 1, testBins5b_12[j]);
     }
+
+    printf("Ziggurat function, same tests:\n");
+    int    testBins5c[20] = {0}, testBins5c_12[24] = {0};
+    double *zigRet;
+    long   tail5c;
+    for (i = 2000; i <= 2000000; i *= 1000)
+    {
+        zigRet = mkArr(i);
+        mean5b = sigma5b = 0;
+        tail5c = 0;
+        printf("expecting around: mean = 0; sigma = 1 (sample size = %d)\n", i);
+        for (j = 0; j < i; j++)
+        {
+            tmp_f     = ziggurat(0, 1);
+            zigRet[j] = tmp_f;
+            mean5b += tmp_f;
+            tail5c += (fabs(tmp_f) > 3);
+            if ((tmp_f >= -1) && (tmp_f <= 1))
+            {
+                testBins5c[(int) (tmp_f * 10 + 10)] += 1; //[-1, 1] --> [0, 20]
+            }
+        }
+        mean5b /= i;
+        printf("approximate mean: %10f\n", mean5b);
+        for (j = 0; j < i; j++)
+        {
+            sigma5b += pow((zigRet[j] - mean5b), 2);
+        }
+        sigma5b = sqrt(sigma5b / i);
+        printf("approximate standard deviation: %10f\n", sigma5b);
+        // the tail is where the Ziggurat differs most from the other layers: |x| > 3 with probability erfc(3 / sqrt(2))
+        printf("beyond 3 sigma: %10f (expecting %10f)\n", (double) tail5c / i, erfc(3 / M_SQRT2));
+        for (j = 0; j < 20; j++)
+        {
+            boundLow  = (j - 10.0) / 10;
+            boundHigh = boundLow + 0.1;
+            printf("in [%f, %f[: %d\n", boundLow, boundHigh, testBins5c[j]);
+        }
+        free(zigRet);
+    }
+
+    printf("And now for mean = 12.0, sigma = 3.0 (sample size = %d)\n", 2 * sample5b);
+    mean5b = sigma5b = 0;
+    zigRet = mkArr(2 * sample5b);
+    for (i = 0; i < 2 * sample5b; i++)
+    {
+        tmp_f     = ziggurat(12, 3);
+        zigRet[i] = tmp_f;
+        mean5b += tmp_f;
+        if ((tmp_f >= 0) && (tmp_f <= 24))
+        {
+            testBins5c_12[(int) tmp_f] += 1;
+        }
+    }
+    mean5b /= sample5b * 2;
+    printf("approximate mean: %10f\n", mean5b);
+    for (i = 0; i < 2 * sample5b; i++)
+    {
+        sigma5b += pow((zigRet[i] - mean5b), 2);
+    }
+    sigma5b = sqrt(sigma5b / (sample5b * 2));
+    printf("approximate standard deviation: %10f\n", sigma5b);
+    for (j = 0; j < 24; j++)
+    {
+        printf("in [%d, %d[: %d\n", j, j + 1, testBins5c_12[j]);
+    }
+    free(zigRet);
+
+    printf("boxMuller_fill function (%s kernel), same tests:\n", bmSimdLevel() == BM_SIMD_AVX2 ? "avx2" : "scalar");
+    int    testBins5d[20] = {0};
+    double *fillRet       = mkArr(2 * sample5b), *fillRef = mkArr(2 * sample5b);
+    double diff5d         = 0;
+    rng    saved5d;
+    mean5b = sigma5b = 0;
+    rng_get_global(&saved5d);
+    boxMuller_fill(fillRet, 2 * sample5b, 0, 1);
+    for (i = 0; i < 2 * sample5b; i++)
+    {
+        tmp_f = fillRet[i];
+        mean5b += tmp_f;
+        if ((tmp_f >= -1) && (tmp_f <= 1))
+        {
+            testBins5d[(int) (tmp_f * 10 + 10)] += 1; //[-1, 1] --> [0, 20]
+        }
+    }
+    mean5b /= 2 * sample5b;
+    printf("expecting around: mean = 0; sigma = 1 (sample size = %d)\n", 2 * sample5b);
+    printf("approximate mean: %10f\n", mean5b);
+    for (i = 0; i < 2 * sample5b; i++)
+    {
+        sigma5b += pow((fillRet[i] - mean5b), 2);
+    }
+    sigma5b = sqrt(sigma5b / (2 * sample5b));
+    printf("approximate standard deviation: %10f\n", sigma5b);
+    for (j = 0; j < 20; j++)
+    {
+        boundLow  = (j - 10.0) / 10;
+        boundHigh = boundLow + 0.1;
+        printf("in [%f, %f[: %d\n", boundLow, boundHigh, testBins5d[j]);
+    }
+    // the same uniforms again, through the scalar kernel: the polynomials against libm
+    rng_set_global(&saved5d);
+    boxMuller_simd_select(BM_SIMD_SCALAR);
+    boxMuller_fill(fillRef, 2 * sample5b, 0, 1);
+    boxMuller_simd_select(BM_SIMD_AVX2);
+    for (i = 0; i < 2 * sample5b; i++)
+    {
+        diff5d = fmax(diff5d, fabs(fillRet[i] - fillRef[i]));
+    }
+    printf("largest difference with the scalar kernel, same uniforms: %g (expecting under 4e-15)\n", diff5d);
+    free(fillRef);
+
+    struct timespec t0, t1;
+    double          x1, x2, sink5 = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < 5 * sample5b; i++)
+    {
+        boxMuller(&x1, &x2, 0, 1);
+        sink5 += x1 + x2;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("time per number: Box-Muller %.2f ns, ", elapsedNs(&t0, &t1) / (10.0 * sample5b));
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < 10 * sample5b; i++)
+    {
+        sink5 += ziggurat(0, 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("Ziggurat %.2f ns, ", elapsedNs(&t0, &t1) / (10.0 * sample5b));
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < 5; i++)
+    {
+        boxMuller_fill(fillRet, 2 * sample5b, 0, 1);
+        sink5 += fillRet[i];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("boxMuller_fill %.2f ns (sum of some: %f)\n", elapsedNs(&t0, &t1) / (10.0 * sample5b), sink5);
+    free(fillRet);
     printf("(see report for scatter plots of these tests)\n");
 
     printf("########### 6 ###########\n");
@@ -0,0 +1,500 @@
+//
+// Generator throughput benchmark: ns/sample, samples/s and GB/s for every generator and bulk path,
+// each checked against reference outputs first (a fast but wrong kernel fails the run).
+//
+// usage: ./bench [samples [repetitions [reference file]]]
+//   samples      per timed repetition, default 2^24 (0: only check the outputs)
+//   repetitions  timed runs per kernel after one warm-up run, default 11; median, 10th and 90th percentiles reported
+//   reference    default ../matsumoto/mt19937ar.out
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mt.h"
+#include "rng.h"
+#include "simpi.h"
+
+#define DEBUG printf("file %s; line %d\n", __FILE__, __LINE__);
+#define FAIL_OUT DEBUG exit(EXIT_FAILURE);
+#define MALLOC_FAIL printf("!_malloc failed_!\n"); FAIL_OUT
+
+#define REF_FILE "../matsumoto/mt19937ar.out"
+#define REF_COUNT 1000
+#define CHUNK 4096 // buffer size for the bulk kernels, in samples
+
+typedef struct kernel
+{
+    const char *name;
+    int        bytes; // per sample
+    uint64_t   (*run)(size_t n); // draws n samples, returns something depending on all of them
+    int        kind;  // RNG_* engine seeded into handle beforehand, -1 for the global generators
+} kernel;
+
+static uint32_t u32buf[CHUNK];
+static double   dblbuf[CHUNK];
+static rng      handle; // for the non-global engines
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int cmpDbl(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/* p-th percentile (0 to 100) of a sorted array, by linear interpolation */
+static double percentile(const double *sorted, int n, double p)
+{
+    double pos = (n - 1) * p / 100.0;
+    int    lo  = (int) pos;
+    if (lo >= n - 1) return sorted[n - 1];
+    return sorted[lo] + (pos - lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+static uint64_t dblBits(double d)
+{
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    return u;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    KERNELS    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+#define SINGLE_KERNEL(fname, expr) \
+static uint64_t fname(size_t n) \
+{ \
+    uint64_t acc = 0; \
+    for (size_t i = 0; i < n; i++) acc += (expr); \
+    return acc; \
+}
+
+#define FILL_U32_KERNEL(fname, call) \
+static uint64_t fname(size_t n) \
+{ \
+    uint64_t acc = 0; \
+    size_t   k; \
+    for (size_t done = 0; done < n; done += k) \
+    { \
+        k = (n - done < CHUNK) ? n - done : CHUNK; \
+        call; \
+        acc += u32buf[0] + u32buf[k - 1]; \
+    } \
+    return acc; \
+}
+
+#define FILL_DBL_KERNEL(fname, call) \
+static uint64_t fname(size_t n) \
+{ \
+    uint64_t acc = 0; \
+    size_t   k; \
+    for (size_t done = 0; done < n; done += k) \
+    { \
+        k = (n - done < CHUNK) ? n - done : CHUNK; \
+        call; \
+        acc += dblBits(dblbuf[0]) + dblBits(dblbuf[k - 1]); \
+    } \
+    return acc; \
+}
+
+SINGLE_KERNEL(b_int32, genrand_int32())
+SINGLE_KERNEL(b_real1, dblBits(genrand_real1()))
+SINGLE_KERNEL(b_real2, dblBits(genrand_real2()))
+SINGLE_KERNEL(b_real3, dblBits(genrand_real3()))
+SINGLE_KERNEL(b_res53, dblBits(genrand_res53()))
+FILL_U32_KERNEL(b_fill_u32, genrand_fill_u32(u32buf, k))
+FILL_DBL_KERNEL(b_fill_real1, genrand_fill_real1(dblbuf, k))
+FILL_DBL_KERNEL(b_fill_real2, genrand_fill_real2(dblbuf, k))
+FILL_DBL_KERNEL(b_fill_real3, genrand_fill_real3(dblbuf, k))
+FILL_DBL_KERNEL(b_fill_res53, genrand_fill_res53(dblbuf, k))
+SINGLE_KERNEL(b_int64, genrand64_int64())
+SINGLE_KERNEL(b_real2_64, dblBits(genrand64_real2()))
+SINGLE_KERNEL(b_real2_mant, dblBits(genrand64_real2_mant()))
+SINGLE_KERNEL(b_xoshiro, xoshiro256ss_next(&handle.u.xoshiro))
+SINGLE_KERNEL(b_pcg, pcg64_next(&handle.u.pcg))
+SINGLE_KERNEL(b_splitmix, splitmix64_next(&handle.u.splitmix))
+SINGLE_KERNEL(b_philox, philox4x32_next32(&handle.u.philox))
+FILL_U32_KERNEL(b_philox_fill, philox_fill_u32(7, 0, done, u32buf, k))
+SINGLE_KERNEL(b_rng_u32, rng_u32())
+SINGLE_KERNEL(b_rng_real1, dblBits(rng_real1()))
+
+/* simPi_hits() on the points of dblbuf, over and over */
+static uint64_t b_simpi_hits(size_t n)
+{
+    uint64_t acc = 0;
+    size_t   k;
+
+    for (size_t done = 0; done < n; done += k)
+    {
+        k = (n - done < CHUNK / 2) ? n - done : CHUNK / 2;
+        acc += simPi_hits(dblbuf, k);
+    }
+    return acc;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   CHECKING    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/**
+ * readRef
+ * reads the 1000 genrand_int32() and 1000 genrand_real2() outputs of Matsumoto's reference file
+ * @param path said file
+ * @param outInts will house the integers
+ * @param outReals will house the reals, as printed ("%10.8f", without the padding)
+ */
+static void readRef(const char *path, unsigned long *outInts, char outReals[][16])
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    int  i;
+
+    if (f == NULL)
+    {
+        printf("cannot open %s (pass the reference file as 3rd argument)\n", path);
+        FAIL_OUT
+    }
+    if (fgets(line, sizeof(line), f) == NULL) // "1000 outputs of genrand_int32()"
+    {
+        FAIL_OUT
+    }
+    for (i = 0; i < REF_COUNT; i++)
+    {
+        if (fscanf(f, "%lu", &outInts[i]) != 1)
+        {
+            printf("%s: bad integer #%d\n", path, i);
+            FAIL_OUT
+        }
+    }
+    while (fgets(line, sizeof(line), f) != NULL && strstr(line, "genrand_real2") == NULL);
+    for (i = 0; i < REF_COUNT; i++)
+    {
+        if (fscanf(f, "%15s", outReals[i]) != 1)
+        {
+            printf("%s: bad real #%d\n", path, i);
+            FAIL_OUT
+        }
+    }
+    fclose(f);
+}
+
+/* counts and reports the outputs that differ from the reference; 0 when all match */
+static int checkOutputs(const char *what, const unsigned long *ints, const double *reals,
+                        const unsigned long *refInts, char refReals[][16])
+{
+    char str[32];
+    int  bad = 0;
+
+    for (int i = 0; i < REF_COUNT; i++)
+    {
+        sprintf(str, "%10.8f", reals[i]);
+        if (ints[i] != refInts[i] || strcmp(str + strspn(str, " "), refReals[i]) != 0)
+        {
+            if (bad == 0) printf("  %s: first mismatch at output #%d\n", what, i);
+            bad++;
+        }
+    }
+    printf("  %-44s %s\n", what, bad ? "MISMATCH" : "ok");
+    return bad;
+}
+
+/* MT19937 against the reference file, through every path and SIMD level; returns the number of failures */
+static int checkMt(const char *path)
+{
+    static unsigned long refInts[REF_COUNT], ints[REF_COUNT];
+    static char          refReals[REF_COUNT][16];
+    static double        reals[REF_COUNT];
+    static const char    *levels[] = {"scalar", "sse2", "avx2"};
+    unsigned long        init[4]   = {0x123, 0x234, 0x345, 0x456};
+    uint32_t             u32[REF_COUNT];
+    char                 what[64];
+    int                  fails     = 0, i;
+
+    readRef(path, refInts, refReals);
+    for (int level = MT_SIMD_SCALAR; level <= MT_SIMD_AVX2; level++)
+    {
+        if (mt_simd_select(level) != level) continue; // not on this CPU
+
+        init_by_array(init, 4);
+        for (i = 0; i < REF_COUNT; i++) ints[i] = genrand_int32();
+        for (i = 0; i < REF_COUNT; i++) reals[i] = genrand_real2();
+        sprintf(what, "genrand_int32/real2 (%s)", levels[level]);
+        fails += checkOutputs(what, ints, reals, refInts, refReals) != 0;
+
+        init_by_array(init, 4);
+        genrand_fill_u32(u32, 3); // uneven chunks, across refills
+        genrand_fill_u32(u32 + 3, REF_COUNT - 3);
+        for (i = 0; i < REF_COUNT; i++) ints[i] = u32[i];
+        genrand_fill_real2(reals, 700);
+        genrand_fill_real2(reals + 700, REF_COUNT - 700);
+        sprintf(what, "genrand_fill_u32/fill_real2 (%s)", levels[level]);
+        fails += checkOutputs(what, ints, reals, refInts, refReals) != 0;
+    }
+    mt_simd_select(MT_SIMD_AVX2);
+
+    // the other MT19937 doubles: same draws as genrand_int32(), other scaling
+    init_by_array(init, 4);
+    genrand_fill_real1(reals, REF_COUNT);
+    for (i = 0; i < REF_COUNT && reals[i] == refInts[i] * (1.0 / 4294967295.0); i++);
+    init_by_array(init, 4);
+    genrand_fill_real3(reals, REF_COUNT);
+    if (i == REF_COUNT) for (i = 0; i < REF_COUNT && reals[i] == (refInts[i] + 0.5) * (1.0 / 4294967296.0); i++);
+    printf("  %-44s %s\n", "genrand_fill_real1/fill_real3", i == REF_COUNT ? "ok" : "MISMATCH");
+    fails += i != REF_COUNT;
+
+    return fails;
+}
+
+/* known-answer checks of the other engines; returns the number of failures */
+static int checkEngines(void)
+{
+    uint64_t         init64[4]  = {0x12345ULL, 0x23456ULL, 0x34567ULL, 0x45678ULL};
+    uint64_t         ref64[5]   = {7266447313870364031ULL, 4946485549665804864ULL, 16945909448695747420ULL,
+                                   16394063075524226720ULL, 4873882236456199058ULL};
+    uint64_t         refXo[4]   = {11520ULL, 0ULL, 1509978240ULL, 1215971899390074240ULL};
+    uint64_t         refSm[3]   = {6457827717110365317ULL, 3203168211198807973ULL, 9817491932198370423ULL};
+    uint64_t         refPcg[3]  = {0x86b1da1d72062b68ULL, 0x1304aa46c9853d39ULL, 0xa3670e9e0dd50358ULL};
+    uint32_t         ctr[4]     = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+    uint32_t         key[2]     = {0xa4093822, 0x299f31d0};
+    uint32_t         refPh[4]   = {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}, out[4], buf[8];
+    xoshiro256_state xo         = {{1, 2, 3, 4}};
+    splitmix64_state sm         = {1234567};
+    pcg64_state      pcg        = {0, 0, 0, (54ULL << 1) | 1};
+    int              fails      = 0, ok, i;
+
+    init_by_array64(init64, 4);
+    for (ok = 1, i = 0; i < 5; i++) ok &= genrand64_int64() == ref64[i];
+    printf("  %-44s %s\n", "mt19937-64 (mt19937-64.out)", ok ? "ok" : "MISMATCH");
+    fails += !ok;
+
+    for (ok = 1, i = 0; i < 4; i++) ok &= xoshiro256ss_next(&xo) == refXo[i];
+    printf("  %-44s %s\n", "xoshiro256** (state {1, 2, 3, 4})", ok ? "ok" : "MISMATCH");
+    fails += !ok;
+
+    for (ok = 1, i = 0; i < 3; i++) ok &= splitmix64_next(&sm) == refSm[i];
+    printf("  %-44s %s\n", "splitmix64 (seed 1234567)", ok ? "ok" : "MISMATCH");
+    fails += !ok;
+
+    pcg64_step(&pcg); // pcg64_srandom_r(42, 54)
+    pcg.state_lo += 42;
+    pcg64_step(&pcg);
+    for (ok = 1, i = 0; i < 3; i++) ok &= pcg64_next(&pcg) == refPcg[i];
+    printf("  %-44s %s\n", "pcg64 (pcg64-demo, 42/54)", ok ? "ok" : "MISMATCH");
+    fails += !ok;
+
+    philox4x32_10(ctr, key, out);
+    for (ok = 1, i = 0; i < 4; i++) ok &= out[i] == refPh[i];
+    ctr[0] = 5; // and the batch path, from the middle of block 5 of that stream
+    ctr[1] = 0;
+    philox4x32_10(ctr, key, out);
+    philox_fill_u32((uint64_t) key[1] << 32 | key[0], (uint64_t) ctr[3] << 32 | ctr[2], 5 * 4 + 1, buf, 7);
+    for (i = 0; i < 3; i++) ok &= buf[i] == out[i + 1];
+    printf("  %-44s %s\n", "philox4x32-10 (Random123 kat_vectors)", ok ? "ok" : "MISMATCH");
+    fails += !ok;
+
+    return fails;
+}
+
+/*
+ * the global functions (static inline ones in an RNG_STATIC build) against the handle ones, on the same engine and
+ * seed, u32, u64, real and bulk draws interleaved; returns the number of failures
+ */
+static int checkGlobal(void)
+{
+    uint32_t words[7];
+    rng      h, saved;
+    int      fails = 0, ok, i, kind;
+
+    rng_get_global(&saved);
+#ifdef RNG_STATIC
+    for (kind = RNG_STATIC; kind == RNG_STATIC; kind++)
+#else
+    for (kind = 0; kind < RNG_KINDS; kind++)
+#endif
+    {
+        rng_use(kind, 5489ULL);
+        rng_seed(&h, kind, 5489ULL);
+        for (ok = 1, i = 0; i < 100; i++)
+        {
+            ok &= rng_u32() == rng_u32_r(&h);
+            ok &= rng_u64() == rng_u64_r(&h);
+            ok &= rng_u32() == rng_u32_r(&h);
+            ok &= rng_real1() == rng_real1_r(&h);
+            rng_fill_u32(words, 7);
+            for (int j = 0; j < 7; j++) ok &= words[j] == rng_u32_r(&h);
+        }
+        printf("  %-44s %s\n", rng_name(kind), ok ? "ok" : "MISMATCH");
+        fails += !ok;
+    }
+    rng_set_global(&saved);
+    return fails;
+}
+
+/* simPi_hits_u32() on the points of u32buf, over and over */
+static uint64_t b_simpi_hits_u32(size_t n)
+{
+    uint64_t acc = 0;
+    size_t   k;
+
+    for (size_t done = 0; done < n; done += k)
+    {
+        k = (n - done < CHUNK / 2) ? n - done : CHUNK / 2;
+        acc += simPi_hits_u32(u32buf, k);
+    }
+    return acc;
+}
+
+/* every simPi_hits() kernel against the scalar one, on uneven lengths; returns the number of failures */
+static int checkSimPi(void)
+{
+    unsigned long long ref[8], refU32[8], hits;
+    size_t             lens[8] = {0, 1, 3, 7, 8, 9, 1000, CHUNK / 2};
+    int                fails   = 0, i;
+
+    genrand_fill_real1(dblbuf, CHUNK);
+    genrand_fill_u32(u32buf, CHUNK);
+    simPi_simd_select(SIMPI_SIMD_SCALAR);
+    for (i = 0; i < 8; i++) ref[i] = simPi_hits(dblbuf, lens[i]);
+    for (i = 0; i < 8; i++) refU32[i] = simPi_hits_u32(u32buf, lens[i]);
+    for (int level = SIMPI_SIMD_AVX2; level <= SIMPI_SIMD_AVX512; level++)
+    {
+        if (simPi_simd_select(level) != level) continue;
+        for (i = 0, hits = 0; i < 8 && (hits = simPi_hits(dblbuf, lens[i])) == ref[i]; i++);
+        printf("  simPi_hits (%-6s) against scalar             %s\n", level == SIMPI_SIMD_AVX2 ? "avx2" : "avx512",
+               i == 8 ? "ok" : "MISMATCH");
+        fails += i != 8;
+        for (i = 0, hits = 0; i < 8 && (hits = simPi_hits_u32(u32buf, lens[i])) == refU32[i]; i++);
+        printf("  simPi_hits_u32 (%-6s) against scalar         %s\n", level == SIMPI_SIMD_AVX2 ? "avx2" : "avx512",
+               i == 8 ? "ok" : "MISMATCH");
+        fails += i != 8;
+    }
+    simPi_simd_select(SIMPI_SIMD_AVX512);
+    return fails;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------     MAIN      -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/**
+ * timeKernel
+ * one warm-up run, then reps timed runs of n samples; prints median and percentiles
+ */
+static void timeKernel(const kernel *k, size_t n, int reps)
+{
+    double            *ns  = malloc(sizeof(double) * reps);
+    double            t0, med;
+    volatile uint64_t sink = 0;
+
+    if (ns == NULL)
+    {
+        MALLOC_FAIL
+    }
+    sink += k->run(n);
+    for (int r = 0; r < reps; r++)
+    {
+        t0 = now();
+        sink += k->run(n);
+        ns[r] = (now() - t0) * 1e9 / n;
+    }
+    qsort(ns, reps, sizeof(double), cmpDbl);
+    med = percentile(ns, reps, 50);
+    printf("%-28s %8.3f %8.3f %8.3f %12.1f %8.3f\n", k->name, med, percentile(ns, reps, 10),
+           percentile(ns, reps, 90), 1e3 / med, k->bytes / med);
+    (void) sink;
+    free(ns);
+}
+
+int main(int argc, char **argv)
+{
+    size_t        n       = (argc > 1) ? strtoull(argv[1], NULL, 0) : (1U << 24);
+    int           reps    = (argc > 2) ? atoi(argv[2]) : 11;
+    const char    *ref    = (argc > 3) ? argv[3] : REF_FILE;
+    unsigned long init[4] = {0x123, 0x234, 0x345, 0x456};
+    int           fails;
+    kernel        kernels[] = {
+            {"genrand_int32",           4, b_int32,        -1},
+            {"genrand_real1",           8, b_real1,        -1},
+            {"genrand_real2",           8, b_real2,        -1},
+            {"genrand_real3",           8, b_real3,        -1},
+            {"genrand_res53",           8, b_res53,        -1},
+            {"genrand_fill_u32",        4, b_fill_u32,     -1},
+            {"genrand_fill_real1",      8, b_fill_real1,   -1},
+            {"genrand_fill_real2",      8, b_fill_real2,   -1},
+            {"genrand_fill_real3",      8, b_fill_real3,   -1},
+            {"genrand_fill_res53",      8, b_fill_res53,   -1},
+            {"genrand64_int64",         8, b_int64,        -1},
+            {"genrand64_real2",         8, b_real2_64,     -1},
+            {"genrand64_real2_mant",    8, b_real2_mant,   -1},
+            {"xoshiro256** (u64)",      8, b_xoshiro,      RNG_XOSHIRO256SS},
+            {"pcg64 (u64)",             8, b_pcg,          RNG_PCG64},
+            {"splitmix64 (u64)",        8, b_splitmix,     RNG_SPLITMIX64},
+            {"philox4x32 (u32)",        4, b_philox,       RNG_PHILOX4X32},
+            {"philox_fill_u32",         4, b_philox_fill,  -1},
+            {"rng_u32 (runtime mt)",    4, b_rng_u32,      -1},
+            {"rng_real1 (runtime mt)",  8, b_rng_real1,    -1},
+    };
+    static const char *levels[] = {"scalar", "sse2", "avx2"};
+    char               name[64];
+
+    printf("checking outputs against %s and known-answer vectors\n", ref);
+    fails = checkMt(ref) + checkEngines() + checkGlobal() + checkSimPi();
+    if (fails)
+    {
+        printf("%d check(s) failed: not timing anything\n", fails);
+        return EXIT_FAILURE;
+    }
+    if (n == 0 || reps < 1) return 0;
+
+    printf("\n%zu samples x %d repetitions (after 1 warm-up)\n", n, reps);
+    printf("%-28s %8s %8s %8s %12s %8s\n", "kernel", "ns/smp", "p10", "p90", "Msamples/s", "GB/s");
+    init_by_array(init, 4);
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++)
+    {
+        if (kernels[i].kind >= 0) rng_seed(&handle, kernels[i].kind, 5489);
+        timeKernel(&kernels[i], n, reps);
+    }
+
+    // refill kernels one by one, through the bulk path (where they weigh the most)
+    for (int level = MT_SIMD_SCALAR; level <= MT_SIMD_AVX2; level++)
+    {
+        if (mt_simd_select(level) != level) continue;
+        sprintf(name, "genrand_fill_u32 [%s]", levels[level]);
+        kernel k = {name, 4, b_fill_u32, -1};
+        timeKernel(&k, n, reps);
+    }
+    mt_simd_select(MT_SIMD_AVX2);
+
+    // simPi hit counting, per point (16 bytes of uniforms)
+    static const char *piLevels[] = {"scalar", "avx2", "avx512"};
+    genrand_fill_real1(dblbuf, CHUNK);
+    for (int level = SIMPI_SIMD_SCALAR; level <= SIMPI_SIMD_AVX512; level++)
+    {
+        if (simPi_simd_select(level) != level) continue;
+        sprintf(name, "simPi_hits [%s]", piLevels[level]);
+        kernel k = {name, 16, b_simpi_hits, -1};
+        timeKernel(&k, n, reps);
+    }
+    genrand_fill_u32(u32buf, CHUNK);
+    for (int level = SIMPI_SIMD_SCALAR; level <= SIMPI_SIMD_AVX512; level++)
+    {
+        if (simPi_simd_select(level) != level) continue;
+        sprintf(name, "simPi_hits_u32 [%s]", piLevels[level]);
+        kernel k = {name, 8, b_simpi_hits_u32, -1};
+        timeKernel(&k, n, reps);
+    }
+    simPi_simd_select(SIMPI_SIMD_AVX512);
+    return 0;
+}
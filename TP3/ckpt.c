@@ -0,0 +1,292 @@
+//
+// Checkpoints, see ckpt.h
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ckpt.h"
+
+#define CKPT_MAX_STATE (8 * MT64_NN + 4) /* largest engine state, in bytes */
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+static unsigned char *put32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        *p++ = (unsigned char) (v >> (8 * i));
+    }
+    return p;
+}
+
+static unsigned char *put64(unsigned char *p, uint64_t v)
+{
+    return put32(put32(p, (uint32_t) v), (uint32_t) (v >> 32));
+}
+
+static uint32_t get32(const unsigned char **p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        v |= (uint32_t) *(*p)++ << (8 * i);
+    }
+    return v;
+}
+
+static uint64_t get64(const unsigned char **p)
+{
+    uint64_t lo = get32(p);
+    return lo | ((uint64_t) get32(p) << 32);
+}
+
+static uint32_t fnv1a(const unsigned char *p, size_t n)
+{
+    uint32_t h = 2166136261U;
+    for (size_t i = 0; i < n; i++)
+    {
+        h = (h ^ p[i]) * 16777619U;
+    }
+    return h;
+}
+
+/* engine state, field by field; returns the number of bytes written */
+static size_t packState(const rng *r, unsigned char *buf)
+{
+    unsigned char *p = buf;
+    int           i;
+
+    switch (r->kind)
+    {
+        case RNG_MT19937:
+            for (i = 0; i < N; i++) p = put32(p, r->u.mt.mt[i]);
+            p = put32(p, (uint32_t) r->u.mt.mti);
+            break;
+        case RNG_MT19937_64:
+            for (i = 0; i < MT64_NN; i++) p = put64(p, r->u.mt64.mt[i]);
+            p = put32(p, (uint32_t) r->u.mt64.mti);
+            break;
+        case RNG_XOSHIRO256SS:
+            for (i = 0; i < 4; i++) p = put64(p, r->u.xoshiro.s[i]);
+            break;
+        case RNG_PCG64:
+            p = put64(p, r->u.pcg.state_hi);
+            p = put64(p, r->u.pcg.state_lo);
+            p = put64(p, r->u.pcg.inc_hi);
+            p = put64(p, r->u.pcg.inc_lo);
+            break;
+        case RNG_SPLITMIX64:
+            p = put64(p, r->u.splitmix.s);
+            break;
+        case RNG_PHILOX4X32:
+            p = put32(p, r->u.philox.key[0]);
+            p = put32(p, r->u.philox.key[1]);
+            p = put64(p, r->u.philox.stream);
+            p = put64(p, r->u.philox.block);
+            for (i = 0; i < 4; i++) p = put32(p, r->u.philox.buf[i]);
+            p = put32(p, (uint32_t) r->u.philox.idx);
+            break;
+        default:
+            break;
+    }
+    return (size_t) (p - buf);
+}
+
+/* size of what packState() writes for a given engine, 0 for an unknown one */
+static size_t stateSize(int kind)
+{
+    switch (kind)
+    {
+        case RNG_MT19937:
+            return 4 * N + 4;
+        case RNG_MT19937_64:
+            return 8 * MT64_NN + 4;
+        case RNG_XOSHIRO256SS:
+        case RNG_PCG64:
+            return 4 * 8;
+        case RNG_SPLITMIX64:
+            return 8;
+        case RNG_PHILOX4X32:
+            return 2 * 4 + 2 * 8 + 4 * 4 + 4;
+        default:
+            return 0;
+    }
+}
+
+/* the other way around; returns 0 if len is what the engine needs and the indices into the state are in range (the
+ * checksum only catches accidents: the next draw must not read out of bounds), -1 otherwise */
+static int unpackState(rng *r, int kind, const unsigned char *p, size_t len)
+{
+    rng tmp;
+    int i;
+
+    if (stateSize(kind) == 0 || stateSize(kind) != len) return -1;
+    tmp.kind = kind;
+
+    switch (kind)
+    {
+        case RNG_MT19937:
+            for (i = 0; i < N; i++) tmp.u.mt.mt[i] = get32(&p);
+            tmp.u.mt.mti = (int) get32(&p);
+            if (tmp.u.mt.mti < 0 || tmp.u.mt.mti > N) return -1;
+            break;
+        case RNG_MT19937_64:
+            for (i = 0; i < MT64_NN; i++) tmp.u.mt64.mt[i] = get64(&p);
+            tmp.u.mt64.mti = (int) get32(&p);
+            if (tmp.u.mt64.mti < 0 || tmp.u.mt64.mti > MT64_NN) return -1;
+            break;
+        case RNG_XOSHIRO256SS:
+            for (i = 0; i < 4; i++) tmp.u.xoshiro.s[i] = get64(&p);
+            break;
+        case RNG_PCG64:
+            tmp.u.pcg.state_hi = get64(&p);
+            tmp.u.pcg.state_lo = get64(&p);
+            tmp.u.pcg.inc_hi   = get64(&p);
+            tmp.u.pcg.inc_lo   = get64(&p);
+            break;
+        case RNG_SPLITMIX64:
+            tmp.u.splitmix.s = get64(&p);
+            break;
+        default: // RNG_PHILOX4X32
+            tmp.u.philox.key[0] = get32(&p);
+            tmp.u.philox.key[1] = get32(&p);
+            tmp.u.philox.stream = get64(&p);
+            tmp.u.philox.block  = get64(&p);
+            for (i = 0; i < 4; i++) tmp.u.philox.buf[i] = get32(&p);
+            tmp.u.philox.idx = (int) get32(&p);
+            if (tmp.u.philox.idx < 0 || tmp.u.philox.idx > 4) return -1;
+    }
+    *r = tmp;
+    return 0;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   BUSINESS    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+int ckpt_save(const char *path, const rng *inGen, const uint64_t *inPayload, uint32_t inWords)
+{
+    size_t        size = 4 + 4 + 4 + 4 + CKPT_MAX_STATE + 4 + 8 * (size_t) inWords + 4;
+    unsigned char *buf = malloc(size), *p;
+    char          *tmpPath;
+    size_t        stateLen, len;
+    FILE          *f;
+    int           res  = -1;
+
+    tmpPath = malloc(strlen(path) + 5);
+    if (buf == NULL || tmpPath == NULL)
+    {
+        free(buf);
+        free(tmpPath);
+        return -1;
+    }
+
+    memcpy(buf, "Y2CK", 4);
+    p        = put32(buf + 4, CKPT_VERSION);
+    p        = put32(p, inGen != NULL ? (uint32_t) inGen->kind : CKPT_NO_RNG);
+    stateLen = inGen != NULL ? packState(inGen, p + 4) : 0;
+    p        = put32(p, (uint32_t) stateLen) + stateLen;
+    p        = put32(p, inWords);
+    for (uint32_t i = 0; i < inWords; i++)
+    {
+        p = put64(p, inPayload[i]);
+    }
+    len = (size_t) (p - buf);
+    p   = put32(p, fnv1a(buf, len));
+    len += 4;
+
+    sprintf(tmpPath, "%s.tmp", path);
+    f = fopen(tmpPath, "wb");
+    if (f != NULL)
+    {
+        if (fwrite(buf, 1, len, f) == len && fclose(f) == 0)
+        {
+            res = rename(tmpPath, path) == 0 ? 0 : -1;
+        } else
+        {
+            remove(tmpPath);
+        }
+    }
+    free(buf);
+    free(tmpPath);
+    return res;
+}
+
+/* checks and decodes a whole checkpoint file held in buf; returns 0 if it is valid, -1 otherwise */
+static int parse(const unsigned char *buf, size_t len, rng *outGen, uint64_t *outPayload, uint32_t inWords)
+{
+    const unsigned char *p   = buf + 4, *sum = buf + len - 4;
+    uint32_t            kind, stateLen;
+    rng                 gen;
+
+    if (len < 20 || memcmp(buf, "Y2CK", 4) != 0 || get32(&p) != CKPT_VERSION) return -1;
+    if (get32(&sum) != fnv1a(buf, len - 4)) return -1;
+
+    kind     = get32(&p);
+    stateLen = get32(&p);
+    if (len != 4 + 4 + 4 + 4 + (size_t) stateLen + 4 + 8 * (size_t) inWords + 4) return -1;
+    if (outGen == NULL)
+    {
+        if (kind != CKPT_NO_RNG || stateLen != 0) return -1;
+    } else if (unpackState(&gen, (int) kind, p, stateLen) != 0)
+    {
+        return -1;
+    }
+    p += stateLen;
+    if (get32(&p) != inWords) return -1;
+
+    for (uint32_t i = 0; i < inWords; i++)
+    {
+        outPayload[i] = get64(&p);
+    }
+    if (outGen != NULL) *outGen = gen;
+    return 0;
+}
+
+int ckpt_load(const char *path, rng *outGen, uint64_t *outPayload, uint32_t inWords)
+{
+    size_t        size = 4 + 4 + 4 + 4 + CKPT_MAX_STATE + 4 + 8 * (size_t) inWords + 4;
+    unsigned char *buf;
+    size_t        len;
+    FILE          *f;
+    int           res;
+
+    f = fopen(path, "rb");
+    if (f == NULL) return -1;
+    buf = malloc(size + 1);
+    if (buf == NULL)
+    {
+        fclose(f);
+        return -1;
+    }
+    len = fread(buf, 1, size + 1, f); // one more byte than the largest valid file, to see oversized ones
+    fclose(f);
+
+    res = (len <= size) ? parse(buf, len, outGen, outPayload, inWords) : -1;
+    free(buf);
+    return res;
+}
+
+uint32_t ckpt_fingerprint(const rng *inGen)
+{
+    unsigned char buf[CKPT_MAX_STATE];
+
+    return fnv1a(buf, packState(inGen, buf)) ^ (uint32_t) inGen->kind;
+}
+
+uint64_t dbl_to_u64(double d)
+{
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    return u;
+}
+
+double u64_to_dbl(uint64_t u)
+{
+    double d;
+    memcpy(&d, &u, sizeof(d));
+    return d;
+}
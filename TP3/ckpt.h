@@ -0,0 +1,52 @@
+//
+// Checkpoints: generator state + a few accumulators, so that a long run can resume exactly where it stopped.
+//
+// File format (all fields little-endian):
+//   "Y2CK" | version (u32) | engine kind (u32) | state size in bytes (u32) | engine state
+//   | payload size in words (u32) | payload (u64 words) | FNV-1a checksum of everything before it (u32)
+// The engine state is written field by field (MT19937: 624 u32 words then mti, ...), so it does not depend
+// on struct padding or on the size of unsigned long. A checkpoint with no generator (payload only) has the engine
+// kind CKPT_NO_RNG and a state of 0 bytes.
+//
+
+#ifndef Y2_C_SIM_CKPT_H
+#define Y2_C_SIM_CKPT_H
+
+#include <stdint.h>
+#include "rng.h"
+
+#define CKPT_VERSION 1
+#define CKPT_NO_RNG 0xffffffffU // engine kind of a checkpoint without generator
+
+/**
+ * ckpt_save
+ * writes a checkpoint, through a temporary file and a rename, so that a crash mid-write leaves the previous one
+ * @param path said file
+ * @param inGen generator to save, NULL for none
+ * @param inPayload caller's accumulators (doubles go in with dbl_to_u64())
+ * @param inWords number of words in inPayload
+ * @return 0 on success, -1 otherwise
+ */
+int ckpt_save(const char *path, const rng *inGen, const uint64_t *inPayload, uint32_t inWords);
+
+/**
+ * ckpt_load
+ * reads a checkpoint back
+ * @param path said file
+ * @param outGen will house the saved generator, NULL for a checkpoint saved without one (the only kind it then reads)
+ * @param outPayload will house the saved accumulators
+ * @param inWords number of words expected in the payload
+ * @return 0 if a checkpoint with the right version, checksum and payload size was read, -1 otherwise
+ * (missing file included): outGen and outPayload are only written on success
+ */
+int ckpt_load(const char *path, rng *outGen, uint64_t *outPayload, uint32_t inWords);
+
+/* checksum of a generator's state: tells whether a run has come back to the same point */
+uint32_t ckpt_fingerprint(const rng *inGen);
+
+/* bit-exact doubles in payloads */
+uint64_t dbl_to_u64(double d);
+
+double u64_to_dbl(uint64_t u);
+
+#endif //Y2_C_SIM_CKPT_H
@@ -3,8 +3,20 @@
 //
 
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ckpt.h"
+#include "mcint.h"
 #include "mt.h"
+#include "procrun.h"
+#include "qmc.h"
+#include "rng.h"
+#include "sched.h"
+#include "simpi.h"
+#include "stats.h"
+#include "vr.h"
 
 #define MAX_POINTS 1000000000
 //#define MAX_POINTS 10000000 //faster
@@ -12,11 +24,46 @@
 #define SIZE_2 30
 #define SIZE_2_MAX 30
 #define SIZE_3_MAX 30
+#define BATCH 1024 // points per batch of uniforms
+#define CKPT_MIN_POINTS 100000000 // grid replicates of at least that many points write checkpoints
+#define SEQ_MIN_REPS 5 // sequential estimation: replicates before the first stopping check...
+#define SEQ_MAX_REPS 10000 // ...and at most
+#define MCINT_POINTS (MIL / 10) // points per mcint_run() replicate
+#define ASIAN_DATES 64 // monitoring dates of the Asian option, one dimension each
+#define VR_POINTS (MIL / 100) // evaluations per variance reduction replicate, a square for vr_stratified()
+#define GRID_CHUNK (MIL / 4) // the experiment grid runs in tasks of at most that many points
+#define CKPT_GRID "grid.ckpt"
+#define CKPT_PROC "proc-%llu.ckpt" // section 2 in worker processes: one file per # of points
 
 /*-------------------------------------------------------------------------------*/
 /*-----------------------------    ANNEXES    -----------------------------------*/
 /*-------------------------------------------------------------------------------*/
 
+/**
+ * printReplicates
+ * prints replicates of pi at some # of points, then their mean and its errors
+ * @param res said replicates
+ * @param inReps number of replicates
+ * @param inPoints points per replicate
+ */
+void printReplicates(const double *res, int inReps, unsigned long long inPoints)
+{
+    double mean = 0.0, err;
+
+    printf("\n%llu points, sample size = %d\n", inPoints, inReps);
+    for (int i = 0; i < inReps; i++)
+    {
+        printf("%10.8f, ", res[i]);
+        mean += res[i];
+    }
+
+    mean /= inReps;
+    printf("\nmean = %10.8f\n", mean);
+    err = fabs(mean - M_PI);
+    printf("absolute error = %10.8f\n", err);
+    printf("relative error = %10.8f\n", err / M_PI);
+}
+
 /*-------------------------------------------------------------------------------*/
 /*-----------------------------   BUSINESS    -----------------------------------*/
 /*-------------------------------------------------------------------------------*/
@@ -26,35 +73,540 @@
  * uses a Monte Carlo simulation to approximate pi
  * <br><em>effective, but not so efficient</em>
  * -- gets quite slow past 10^7 points (i.e. 3-decimal precision)
+ * <br>the uniforms are drawn BATCH points at a time, and the hits counted by simPi_hits() (SIMD, see simpi.h):
+ * same draws, same test, same result as one point at a time
  * @param inPoints number of random points used to approximate pi
  * @return said approximation of pi
  */
 double simPi(unsigned long long inPoints)
 {
-    double             x, y, m = 0;
-    unsigned long long i_l     = 0;
-    while (i_l++ < inPoints)
+    double             xy[2 * BATCH];
+    unsigned long long i_l     = 0, m = 0, n;
+    while (i_l < inPoints)
     {
-        x = genrand_real1();
-        y = genrand_real1();
-        if (pow(x, 2) + pow(y, 2) < 1)
+        n = (inPoints - i_l < BATCH) ? inPoints - i_l : BATCH;
+        rng_fill_real1(xy, 2 * n);
+        m += simPi_hits(xy, n);
+        i_l += n;
+    }
+    return (m / (double) inPoints) * 4;
+}
+
+/**
+ * simPiReplicate
+ * one simPi() replicate, as seq_estimate() draws them
+ * @param ctx points to the number of random points
+ * @return said replicate
+ */
+double simPiReplicate(void *ctx)
+{
+    return simPi(*(unsigned long long *) ctx);
+}
+
+/**
+ * simPi_qmc
+ * simPi() on the next inPoints points of a 2-dimensional quasi-Monte Carlo sequence instead of random ones
+ * <br>on a randomized sequence, one call per seed makes independent replicates (see qmc.h)
+ * @param q said sequence, 2-dimensional
+ * @param inPoints number of points used to approximate pi
+ * @return said approximation of pi
+ */
+double simPi_qmc(qmc *q, unsigned long long inPoints)
+{
+    double             xy[2 * BATCH];
+    unsigned long long i_l = 0, m = 0, n;
+
+    while (i_l < inPoints)
+    {
+        n = (inPoints - i_l < BATCH) ? inPoints - i_l : BATCH;
+        qmc_fill(q, xy, n);
+        m += simPi_hits(xy, n);
+        i_l += n;
+    }
+    return (m / (double) inPoints) * 4;
+}
+
+/* a randomized QMC replicate setting, for simPiReplicate_qmc() */
+typedef struct rqmc_job
+{
+    int                kind;     // QMC_SOBOL, QMC_HALTON
+    int                scramble; // QMC_SHIFT, QMC_OWEN
+    uint64_t           seed;     // of the next replicate
+    unsigned long long points;
+} rqmc_job;
+
+/**
+ * simPiReplicate_qmc
+ * one randomized QMC simPi() replicate, as seq_estimate() draws them: a new randomization each time
+ * @param ctx points to an rqmc_job
+ * @return said replicate
+ */
+double simPiReplicate_qmc(void *ctx)
+{
+    rqmc_job *job = ctx;
+    qmc      q;
+
+    qmc_init(&q, job->kind, 2, job->scramble, job->seed++);
+    return simPi_qmc(&q, job->points);
+}
+
+/**
+ * simPi_int
+ * simPi(), on the raw 32-bit words: no conversion to double, and an exact test
+ * (see simPi_hits_u32() in simpi.h for how it maps to the real-valued estimator)
+ * <br>on mt19937, same draws as simPi(), so same result but for points within a rounding error of the circle
+ * @param inPoints number of random points used to approximate pi
+ * @return said approximation of pi
+ */
+double simPi_int(unsigned long long inPoints)
+{
+    uint32_t           uv[2 * BATCH];
+    unsigned long long i_l = 0, m = 0, n;
+
+    while (i_l < inPoints)
+    {
+        n = (inPoints - i_l < BATCH) ? inPoints - i_l : BATCH;
+        rng_fill_u32(uv, 2 * n);
+        m += simPi_hits_u32(uv, n);
+        i_l += n;
+    }
+    return (m / (double) inPoints) * 4;
+}
+
+/**
+ * simPiHits_philox
+ * counts the points of a Philox stream that fall inside the quarter disc, point k using words 2k and 2k + 1
+ * <br><em>points are pure functions of (key, stream, k): splitting a range between calls or threads
+ * gives the same total, bit for bit</em>
+ * @param inKey Philox key
+ * @param inStream Philox stream
+ * @param inFirst index of the first point
+ * @param inPoints number of points
+ * @return number of hits among points [inFirst, inFirst + inPoints[
+ */
+unsigned long long simPiHits_philox(uint64_t inKey, uint64_t inStream,
+                                    unsigned long long inFirst, unsigned long long inPoints)
+{
+    double             xy[2 * BATCH];
+    unsigned long long hits = 0, done = 0;
+    size_t             n;
+
+    while (done < inPoints)
+    {
+        n = (inPoints - done < BATCH) ? (size_t) (inPoints - done) : BATCH;
+        philox_fill_real1(inKey, inStream, 2 * (inFirst + done), xy, 2 * n);
+        hits += simPi_hits(xy, n);
+        done += n;
+    }
+    return hits;
+}
+
+/**
+ * simPiHits_rng
+ * counts the points of a generator that fall inside the quarter disc, drawn as simPi() draws them
+ * @param r said generator, 2 * inPoints draws further on return
+ * @param inPoints number of points
+ * @return number of hits
+ */
+unsigned long long simPiHits_rng(rng *r, unsigned long long inPoints)
+{
+    double             xy[2 * BATCH];
+    unsigned long long hits = 0, done = 0;
+    size_t             n;
+
+    while (done < inPoints)
+    {
+        n = (inPoints - done < BATCH) ? (size_t) (inPoints - done) : BATCH;
+        rng_fill_real1_r(r, xy, 2 * n);
+        hits += simPi_hits(xy, n);
+        done += n;
+    }
+    return hits;
+}
+
+/* a replicate of the experiment grid, on its own substream of the generator, its hits summed by its tasks */
+typedef struct grid_rep
+{
+    rng                *gen;
+    unsigned long long points;
+    unsigned long long hits; // atomic
+    unsigned long long left; // points not counted yet, atomic
+    int                done; // set once hits is final, atomic
+    int                run;  // submitted by gridRun(), or left to other code
+} grid_rep;
+
+/* the experiments of sections 1 to 3, as replicates run at once on a work-stealing scheduler */
+typedef struct grid
+{
+    sched              *s;
+    int                kind;    // generator, RNG_*
+    uint64_t           seed;
+    grid_rep           *reps;
+    rng                *gens;   // replicate r on substream r (see rng_substreams_r())
+    int                count;
+    uint64_t           *saved;  // seed, kind, then done and hits of each replicate, as written to CKPT_GRID
+    pthread_mutex_t    lock;    // one checkpoint written at a time
+    unsigned long long workNs;  // thread CPU time of all the tasks, atomic
+    int                workers; // of the scheduler
+} grid;
+
+/* points [first, first + points[ of a grid replicate */
+typedef struct grid_task
+{
+    grid               *g;
+    grid_rep           *rep;
+    unsigned long long first;
+    unsigned long long points;
+} grid_task;
+
+/**
+ * gridAdd
+ * adds inReps replicates of inPoints points to the grid, each on the next substream
+ * @param g grid
+ * @param inReps number of replicates
+ * @param inPoints points per replicate
+ * @param inRun 0 to leave them out of gridRun()
+ * @return index of the first one in g->reps
+ */
+int gridAdd(grid *g, int inReps, unsigned long long inPoints, int inRun)
+{
+    int first = g->count;
+
+    g->reps = realloc(g->reps, sizeof(grid_rep) * (g->count + inReps));
+    if (g->reps == NULL)
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int r = 0; r < inReps; r++)
+    {
+        g->reps[g->count++] = (grid_rep) {NULL, inPoints, 0, inPoints, 0, inRun};
+    }
+    return first;
+}
+
+/**
+ * gridValue
+ * @param rep a finished replicate
+ * @return its approximation of pi
+ */
+double gridValue(const grid_rep *rep)
+{
+    return (rep->hits / (double) rep->points) * 4;
+}
+
+/**
+ * gridSave
+ * writes the hits of the finished replicates to CKPT_GRID, a rerun only runs the others
+ * <br>each replicate being on a substream of its own, that is all it needs to be resumed
+ * @param g grid
+ */
+void gridSave(grid *g)
+{
+    pthread_mutex_lock(&g->lock);
+    g->saved[0] = g->seed;
+    g->saved[1] = (uint64_t) g->kind;
+    for (int r = 0; r < g->count; r++)
+    {
+        g->saved[2 + 2 * r] = (uint64_t) __atomic_load_n(&g->reps[r].done, __ATOMIC_ACQUIRE);
+        g->saved[3 + 2 * r] = g->saved[2 + 2 * r] ? g->reps[r].hits : 0;
+    }
+    if (ckpt_save(CKPT_GRID, NULL, g->saved, 2 + 2 * g->count) != 0)
+    {
+        printf("could not write %s\n", CKPT_GRID);
+    }
+    pthread_mutex_unlock(&g->lock);
+}
+
+/**
+ * gridTask
+ * a scheduler task: counts the hits of its points into its replicate; the task that counts the last points of a
+ * replicate of CKPT_MIN_POINTS or more writes a checkpoint
+ * <br>on Philox, it first hands over halves of itself to the scheduler until it is down to GRID_CHUNK points (halves
+ * that idle workers steal): Philox points being pure functions of their index, the hits do not depend on how the
+ * range was split. The other engines draw their points one after the other, and run whole replicates
+ * @param arg a grid_task, freed here
+ */
+void gridTask(void *arg)
+{
+    grid_task          *t = arg, *half;
+    struct timespec    t0, t1;
+    unsigned long long hits;
+
+    while (t->g->kind == RNG_PHILOX4X32 && t->points > GRID_CHUNK)
+    {
+        half = malloc(sizeof(grid_task));
+        if (half == NULL)
         {
-            m++;
+            printf("!_malloc failed_!\n");
+            exit(EXIT_FAILURE);
         }
+        *half = *t;
+        half->first  = t->first + t->points / 2;
+        half->points = t->points - t->points / 2;
+        t->points /= 2;
+        sched_submit(t->g->s, gridTask, half);
+    }
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+    if (t->g->kind == RNG_PHILOX4X32)
+    {
+        hits = simPiHits_philox(t->g->seed, t->rep->gen->u.philox.stream, t->first, t->points);
+    } else
+    {
+        hits = simPiHits_rng(t->rep->gen, t->points);
+    }
+    __atomic_fetch_add(&t->rep->hits, hits, __ATOMIC_RELAXED);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+    __atomic_fetch_add(&t->g->workNs,
+                       (unsigned long long) ((t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec)),
+                       __ATOMIC_RELAXED);
+    if (__atomic_sub_fetch(&t->rep->left, t->points, __ATOMIC_ACQ_REL) == 0)
+    {
+        __atomic_store_n(&t->rep->done, 1, __ATOMIC_RELEASE);
+        if (t->rep->points >= CKPT_MIN_POINTS) gridSave(t->g);
+    }
+    free(t);
+}
+
+/**
+ * gridRun
+ * runs the replicates added to the grid, replicate r on substream r of the generator (see rng_substreams_r()),
+ * picking up the finished ones of an interrupted run from CKPT_GRID
+ * <br>the substreams are found first: on mt19937, one jump per replicate (a few milliseconds each)
+ * @param g grid
+ * @param inKind generator, RNG_*
+ * @param inSeed its seed
+ * @param inWorkers number of scheduler workers, 0 for one per online CPU
+ * @return wall time, in seconds
+ */
+double gridRun(grid *g, int inKind, uint64_t inSeed, int inWorkers)
+{
+    grid_task       *task;
+    struct timespec t0, t1;
+    int             resumed = 0;
+
+    g->kind  = inKind;
+    g->seed  = inSeed;
+    g->gens  = malloc(sizeof(rng) * g->count);
+    g->saved = malloc(sizeof(uint64_t) * (2 + 2 * g->count));
+    if (g->gens == NULL || g->saved == NULL)
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (ckpt_load(CKPT_GRID, NULL, g->saved, 2 + 2 * g->count) == 0 && g->saved[0] == g->seed
+        && g->saved[1] == (uint64_t) g->kind)
+    {
+        for (int r = 0; r < g->count; r++)
+        {
+            if (!g->saved[2 + 2 * r]) continue;
+            g->reps[r].hits = g->saved[3 + 2 * r];
+            g->reps[r].left = 0;
+            g->reps[r].done = 1;
+            resumed++;
+        }
+        printf("(resuming from %s: %d replicates done)\n", CKPT_GRID, resumed);
+    }
+    pthread_mutex_init(&g->lock, NULL);
+    g->workNs = 0;
+    g->s      = sched_create(inWorkers);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    rng_substreams_r(g->gens, g->count, g->kind, g->seed);
+    for (int r = 0; r < g->count; r++)
+    {
+        g->reps[r].gen = &g->gens[r];
+        if (!g->reps[r].run || g->reps[r].done) continue;
+        task = malloc(sizeof(grid_task));
+        if (task == NULL)
+        {
+            printf("!_malloc failed_!\n");
+            exit(EXIT_FAILURE);
+        }
+        *task = (grid_task) {g, &g->reps[r], 0, g->reps[r].points};
+        sched_submit(g->s, gridTask, task);
+    }
+    sched_wait(g->s);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    g->workers = sched_workers(g->s);
+    sched_destroy(g->s);
+    remove(CKPT_GRID);
+    pthread_mutex_destroy(&g->lock);
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/**
+ * quarterDisc
+ * the simPi() integrand, as a vr_problem: its mean over the unit square is pi
+ * @param x first coordinate
+ * @param y second coordinate
+ * @param ctx unused
+ * @return 4 inside the quarter disc, 0 outside
+ */
+double quarterDisc(double x, double y, void *ctx)
+{
+    return (x * x + y * y < 1) ? 4.0 : 0.0;
+}
+
+/**
+ * radius2
+ * control variate for quarterDisc(): the squared distance to the origin, of mean 2 / 3,
+ * which gets lower as points get inside the disc
+ * @param x first coordinate
+ * @param y second coordinate
+ * @param ctx unused
+ * @return x^2 + y^2
+ */
+double radius2(double x, double y, void *ctx)
+{
+    return x * x + y * y;
+}
+
+/**
+ * expInverse
+ * the inverse transform of TP2's negExp(), as a vr_problem: its mean over the unit square is the mean of the
+ * exponential distribution (y is unused)
+ * @param x uniform in [0, 1[
+ * @param y unused
+ * @param ctx points to the mean
+ * @return -mean * ln(1 - x)
+ */
+double expInverse(double x, double y, void *ctx)
+{
+    return -*(double *) ctx * log(1 - x);
+}
+
+/**
+ * identity
+ * control variate for expInverse(): the uniform itself, of mean 1 / 2
+ * @param x first coordinate
+ * @param y unused
+ * @param ctx unused
+ * @return x
+ */
+double identity(double x, double y, void *ctx)
+{
+    return x;
+}
+
+/**
+ * nBall
+ * integrand of the volume of the unit ball in dim dimensions, for mcint_run(): 2^dim (the volume of the cube
+ * [-1, 1]^dim) inside the ball, 0 outside, on the point 2x - 1
+ * <br>coordinate by coordinate, so that each loop over the batch vectorizes
+ */
+static void nBall(const double *x, size_t stride, size_t n, int dim, double *out, void *ctx)
+{
+    double cube = ldexp(1.0, dim), t;
+
+    for (size_t k = 0; k < n; k++)
+    {
+        out[k] = 0.0;
+    }
+    for (int j = 0; j < dim; j++)
+    {
+        for (size_t k = 0; k < n; k++)
+        {
+            t = 2 * x[(size_t) j * stride + k] - 1;
+            out[k] += t * t;
+        }
+    }
+    for (size_t k = 0; k < n; k++)
+    {
+        out[k] = out[k] < 1 ? cube : 0.0;
+    }
+}
+
+/* a call option on a Black-Scholes underlying */
+typedef struct option
+{
+    double spot;
+    double strike;
+    double rate;
+    double sigma;
+    double maturity;
+} option;
+
+/**
+ * callPayoff
+ * discounted payoff of a European call whose underlying ends at spot * exp((r - sigma^2 / 2) T + sigma sqrt(T) z)
+ * @param opt said option
+ * @param z standard normal draw
+ * @return said payoff
+ */
+static inline double callPayoff(const option *opt, double z)
+{
+    double end = opt->spot * exp((opt->rate - 0.5 * opt->sigma * opt->sigma) * opt->maturity
+                                 + opt->sigma * sqrt(opt->maturity) * z);
+
+    return end > opt->strike ? exp(-opt->rate * opt->maturity) * (end - opt->strike) : 0.0;
+}
+
+/* European call, for mcint_run(): 2 dimensions, one normal draw by Box-Muller */
+MCINT_POINTWISE(europeanCall, callPayoff(ctx, sqrt(-2 * log(MCINT_X(0))) * cos(2 * M_PI * MCINT_X(1))))
+
+/**
+ * blackScholesCall
+ * closed form of the European call price, to check europeanCall() against
+ * @param opt said option
+ * @return said price
+ */
+double blackScholesCall(const option *opt)
+{
+    double sd = opt->sigma * sqrt(opt->maturity);
+    double d1 = (log(opt->spot / opt->strike) + (opt->rate + 0.5 * opt->sigma * opt->sigma) * opt->maturity) / sd;
+
+    return opt->spot * 0.5 * erfc(-d1 / M_SQRT2)
+           - opt->strike * exp(-opt->rate * opt->maturity) * 0.5 * erfc(-(d1 - sd) / M_SQRT2);
+}
+
+/**
+ * asianCall
+ * discounted payoff of an arithmetic Asian call, for mcint_run(): the underlying is observed on dim evenly spaced
+ * dates (dim even), the Brownian increments being Box-Muller normals from coordinates 2i and 2i + 1
+ * <br>no closed form: the confidence interval is all there is
+ */
+static void asianCall(const double *x, size_t stride, size_t n, int dim, double *out, void *ctx)
+{
+    const option *opt   = ctx;
+    double       dt     = opt->maturity / dim;
+    double       drift  = (opt->rate - 0.5 * opt->sigma * opt->sigma) * dt, vol = opt->sigma * sqrt(dt);
+    double       logS[MCINT_BATCH], avg[MCINT_BATCH], mag, angle;
+
+    for (size_t k = 0; k < n; k++)
+    {
+        logS[k] = log(opt->spot);
+        avg[k]  = 0.0;
+    }
+    for (int j = 0; j < dim; j += 2)
+    {
+        for (size_t k = 0; k < n; k++)
+        {
+            mag   = sqrt(-2 * log(x[(size_t) j * stride + k]));
+            angle = 2 * M_PI * x[(size_t) (j + 1) * stride + k];
+            logS[k] += drift + vol * mag * cos(angle);
+            avg[k] += exp(logS[k]);
+            logS[k] += drift + vol * mag * sin(angle);
+            avg[k] += exp(logS[k]);
+        }
+    }
+    for (size_t k = 0; k < n; k++)
+    {
+        avg[k] /= dim;
+        out[k] = avg[k] > opt->strike ? exp(-opt->rate * opt->maturity) * (avg[k] - opt->strike) : 0.0;
     }
-    return (m / (double) inPoints) * 4;
 }
 
 /*-------------------------------------------------------------------------------*/
 /*-----------------------------     TESTS     -----------------------------------*/
 /*-------------------------------------------------------------------------------*/
 
-int main(void)
+int main(int argc, char **argv)
 {
     // init by M.M.
     int           i, j;
     unsigned long init[4] = {0x123, 0x234, 0x345, 0x456};
     int           length  = 4;
+    unsigned long long i_l;
 
     init_by_array(init, length);
 
@@ -74,67 +626,204 @@ int main(void)
     }
     // making sure that it checks out compared to ../matsumoto/mt19937ar.out
 
+    // making sure that jumping ahead lands where drawing would
+    mt_state     drawn, jumped;
+    mt_jump_poly jp;
+    init_by_array_r(&drawn, init, length);
+    jumped = drawn;
+    mt_jump_poly_pow2(&jp, 20);
+    mt_jump_r(&jumped, &jp);
+    for (i_l = 0; i_l < (1 << 20); i_l++)
+    {
+        genrand_int32_r(&drawn);
+    }
+    for (i = 0; i < 1000 && genrand_int32_r(&drawn) == genrand_int32_r(&jumped); i++);
+    printf("\njump-ahead by 2^20 draws: %s\n", i == 1000 ? "checks out" : "MISMATCH");
+
+    // MT19937-64: first outputs of the reference mt19937-64.out, init_by_array64({0x12345, 0x23456, 0x34567, 0x45678})
+    uint64_t init64[4] = {0x12345ULL, 0x23456ULL, 0x34567ULL, 0x45678ULL};
+    uint64_t ref64[5]  = {7266447313870364031ULL, 4946485549665804864ULL, 16945909448695747420ULL,
+                          16394063075524226720ULL, 4873882236456199058ULL};
+    init_by_array64(init64, 4);
+    for (i = 0; i < 5 && genrand64_int64() == ref64[i]; i++);
+    printf("genrand64_int64() against mt19937-64.out: %s\n", i == 5 ? "checks out" : "MISMATCH");
+
+    rng_use_args(argc, argv); // the rest runs on any generator, mt19937 by default
+
     printf("\n###################### 1 ######################\n");
 
     printf("\nHi there, person correcting this. You might be here a while, simPi() is pretty slow.\n"
-           "To speed up execution, you may comment line 9 and uncomment line 10.\n"
+           "To speed up execution, you may comment the first MAX_POINTS define and uncomment the second one.\n"
            "Thank you for your time!\n\n");
 
     printf("\nTesting simPi() with varying # of points, trying to reach values close to pi\n");
 
-    unsigned long long i_l;
-    i_l = 1000;
-    while (i_l <= MAX_POINTS)
+    printf("(sections 1 to 3 run their replicates at once first, on a work-stealing scheduler: replicate r on "
+           "substream r of the generator, split in tasks of at most %d points on Philox)\n", GRID_CHUNK);
+    grid   g       = {0};
+    int    workers = argc > 3 ? atoi(argv[3]) : 0; // > 0: the section 2 sweep in worker processes instead
+    int    sweep1, rows1 = 0, sweep2, sizes2, first3;
+    double wall1;
+    sweep1 = g.count;
+    for (i_l = 1000; i_l <= MAX_POINTS; i_l *= 10) // going power of 10 by power of 10
+    {
+        gridAdd(&g, 1, i_l, 1);
+        rows1++;
+    }
+    sweep2 = g.count;
+    for (i_l = 1000; i_l <= MAX_POINTS; i_l *= 1000)
+    {
+        gridAdd(&g, SIZE_2, i_l, workers <= 0);
+    }
+    sizes2 = g.count;
+    for (i = 10; i <= SIZE_2_MAX; i += 10)
+    {
+        gridAdd(&g, i, MIL, 1);
+    }
+    first3 = gridAdd(&g, SIZE_3_MAX, MIL, 1);
+    wall1  = gridRun(&g, rng_current(), argc > 2 ? strtoull(argv[2], NULL, 0) : 5489ULL, 0);
+
+    // to look for intervals where decimal precision improves past certain thresholds
+    for (i = 0; i < rows1; i++)
+    {
+        printf("%llu points: %10.8f\n", g.reps[sweep1 + i].points, gridValue(&g.reps[sweep1 + i]));
+    }
+    printf("(all sections: work = %.3f s, wall time = %.3f s on %d worker(s))\n", g.workNs * 1e-9, wall1,
+           g.workers);
+
+    printf("\nsimPi on a Philox stream: %d points at once, and then in uneven chunks (should be the same)\n", MIL);
+    unsigned long long hits1, hits1_chunks = 0, first1 = 0, chunk1 = 1;
+    hits1 = simPiHits_philox(0x123, 0, 0, MIL);
+    while (first1 < MIL)
+    {
+        chunk1 = (first1 + chunk1 * 3 > MIL) ? MIL - first1 : chunk1 * 3;
+        hits1_chunks += simPiHits_philox(0x123, 0, first1, chunk1);
+        first1 += chunk1;
+    }
+    printf("%10.8f, %10.8f\n", 4.0 * hits1 / MIL, 4.0 * hits1_chunks / MIL);
+
+    printf("\nsimPi_hits() kernels on %d points, on doubles and on the same words as integers "
+           "(should all be the same)\n", MIL);
+    static double   xy1[2 * MIL];
+    static uint32_t uv1[2 * MIL];
+    const char      *levels1[] = {"scalar", "avx2", "avx512"};
+    struct timespec t0, t1, t2;
+    mt_state        st1; // not the global generator: the sections below stay on their sequence
+    init_genrand_r(&st1, 5489UL);
+    genrand_fill_real1_r(&st1, xy1, 2 * MIL);
+    init_genrand_r(&st1, 5489UL);
+    genrand_fill_u32_r(&st1, uv1, 2 * MIL);
+    for (i = SIMPI_SIMD_SCALAR; i <= SIMPI_SIMD_AVX512; i++)
+    {
+        if (simPi_simd_select(i) != i) continue; // not on this CPU
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        hits1 = simPi_hits(xy1, MIL);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        hits1_chunks = simPi_hits_u32(uv1, MIL);
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+        printf("%-6s: %llu hits (%.3f ms), %llu integer hits (%.3f ms)\n", levels1[i], hits1,
+               ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9) * 1e3, hits1_chunks,
+               ((t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) * 1e-9) * 1e3);
+    }
+    simPi_simd_select(SIMPI_SIMD_AVX512);
+
+    printf("\nsimPi() and simPi_int() from the same state, %d points (same draws on mt19937)\n", 10 * MIL);
+    double pi1_real, pi1_int;
+    rng    gen1;
+    rng_get_global(&gen1);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    pi1_real = simPi(10 * MIL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    rng_set_global(&gen1);
+    pi1_int = simPi_int(10 * MIL);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    rng_set_global(&gen1); // and back: the sections below stay on their sequence
+    printf("real: %10.8f (%.3f s), integer: %10.8f (%.3f s)\n", pi1_real,
+           (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9, pi1_int,
+           (t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) * 1e-9);
+    uint64_t   uv64[2 * BATCH];
+    mt64_state st64;
+    init_genrand64_r(&st64, 5489ULL);
+    for (hits1 = 0, i_l = 0; i_l < 10 * MIL; i_l += chunk1)
     {
-        printf("%llu points: %10.8f\n", i_l, simPi(i_l));
-        i_l *= 10;
-        // going power of 10 by power of 10
-        // to look for intervals where decimal precision improves past certain thresholds
+        chunk1 = (10 * MIL - i_l < BATCH) ? 10 * MIL - i_l : BATCH;
+        for (i = 0; i < 2 * (int) chunk1; i++) uv64[i] = genrand64_int64_r(&st64);
+        hits1 += simPi_hits_u64(uv64, chunk1);
     }
+    printf("on 64-bit words (mt19937-64, 128-bit test), %llu points: %10.8f\n", i_l, 4.0 * hits1 / i_l);
+
+    printf("\nsimPi over threads, one MT19937 substream each: %d points, seed 5489\n", 10 * MIL);
+    double          pi1, pi1_again;
+    for (i = 1; i <= 8; i *= 2)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        pi1 = simPi_threads(10 * MIL, 5489UL, i);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        printf("%d thread(s): %10.8f (%.3f s)\n", i, pi1,
+               (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9);
+    }
+    pi1       = simPi_threads(10 * MIL, 5489UL, 4);
+    pi1_again = simPi_threads(10 * MIL, 5489UL, 4);
+    printf("same seed, same # of threads: %s\n", pi1 == pi1_again ? "same estimate" : "MISMATCH");
+    // and one thread is simPi() on init_genrand(seed), when the latter runs on mt19937
+    if (rng_current() == RNG_MT19937)
+    {
+        rng_get_global(&gen1);
+        init_genrand(5489UL);
+        pi1 = simPi(MIL);
+        rng_set_global(&gen1);
+        printf("1 thread against simPi(): %s\n", pi1 == simPi_threads(MIL, 5489UL, 1) ? "checks out" : "MISMATCH");
+    }
+    // mcint_run() shares replicates, not points, between threads: the estimate does not depend on their number
+    mcint_result mc1, mc1_threads;
+    mcint_run(nBall, NULL, 2, MIL / 10, 8, 0.95, 5489UL, 1, &mc1);
+    mcint_run(nBall, NULL, 2, MIL / 10, 8, 0.95, 5489UL, 3, &mc1_threads);
+    printf("mcint_run(), 1 against 3 threads: %s\n",
+           mc1.estimate == mc1_threads.estimate && mc1.radius == mc1_threads.radius ? "same estimate" : "MISMATCH");
 
     printf("\n###################### 2 ######################\n");
 
     double res2[SIZE_2];
-    double mean2, tmp, err2, rel_err2;
-    i_l = 1000;
+    double mean2, err2, rel_err2;
+    char   path2[64];
 
     printf("\nTesting with varying # of points, introducing a constant sample size > 1 "
            "to obtain a mean value closer to pi\n");
-    while (i_l <= MAX_POINTS)
-    {
-        mean2 = 0.0;
 
-        for (i = 0; i < SIZE_2; i++) // running SIZE_2 replicates, instead of 1
+    if (workers > 0)
+    {
+        printf("(%d worker processes, replicate i on mt19937 substream i of the seed)\n", workers);
+    }
+    for (i_l = 1000, j = 0; i_l <= MAX_POINTS; i_l *= 1000, j++)
+    {
+        // in worker processes, each on its own substream: a crashed one is run again, and long runs are checkpointed
+        // by the parent as the grid's are
+        if (workers > 0)
         {
-            tmp = simPi(i_l);
-            res2[i] = tmp;
-            mean2 += tmp;
-        }
-        printf("\n%llu points, sample size = %d\n", i_l, SIZE_2);
-        for (i = 0; i < SIZE_2; i++)
+            snprintf(path2, sizeof(path2), CKPT_PROC, i_l);
+            if (proc_run(simPiReplicate, &i_l, SIZE_2, argc > 2 ? strtoul(argv[2], NULL, 0) : 5489UL, workers,
+                         i_l >= CKPT_MIN_POINTS ? path2 : NULL, res2) != 0)
+            {
+                return EXIT_FAILURE;
+            }
+        } else
         {
-            printf("%10.8f, ", res2[i]);
+            for (i = 0; i < SIZE_2; i++) // running SIZE_2 replicates, instead of 1
+            {
+                res2[i] = gridValue(&g.reps[sweep2 + j * SIZE_2 + i]);
+            }
         }
-
-        mean2 /= SIZE_2;
-        printf("\nmean = %10.8f\n", mean2);
-        err2 = fabs(mean2 - M_PI);
-        printf("absolute error = %10.8f\n", err2);
-        rel_err2 = err2 / M_PI;
-        printf("relative error = %10.8f\n", rel_err2);
-
-        i_l *= 1000;
+        printReplicates(res2, SIZE_2, i_l);
     }
 
     printf("\nNow testing the impact of sample size on mean and error, keeping # of points constant\n");
-    for (i = 10; i <= SIZE_2_MAX; i += 10)
+    for (i = 10; i <= SIZE_2_MAX; sizes2 += i, i += 10)
     {
         mean2 = 0.0;
 
         for (j = 0; j < i; j++)
         {
-            tmp = simPi(MIL);
-            mean2 += tmp;
+            mean2 += gridValue(&g.reps[sizes2 + j]);
         }
         printf("\n%d points, sample size = %d\n", MIL, i);
         mean2 /= i;
@@ -151,47 +840,28 @@ int main(void)
 
     printf("\nNow testing the impact of sample size on confidence radius, keeping # of points constant\n");
 
-    double t_vals[30] =
-                   {
-                           12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.308, 2.262, 2.228,
-                           2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
-                           2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
-                   };
+    double  conf_rads3[SIZE_3_MAX];
+    double  std_err3;
+    welford reps3 = WELFORD_INIT;
 
-    double res3[SIZE_3_MAX];
-    double conf_rads3[SIZE_3_MAX];
-    double mean3, est_var3, std_err3, std_dev3;
-
-    for (i = 2; i <= SIZE_3_MAX; i++)
+    // one pass over SIZE_3_MAX replicates: each one joins the previous ones, and the interval is reported
+    // for every sample size on the way (t quantiles with i - 1 degrees of freedom, for any i)
+    for (i = 1; i <= SIZE_3_MAX; i++)
     {
-        mean3    = 0.0;
-        est_var3 = 0.0;
+        welford_add(&reps3, gridValue(&g.reps[first3 + i - 1]));
+        if (i < 2) continue;
 
-        for (j = 0; j < i; j++)
-        {
-            tmp = simPi(MIL);
-            res3[j] = tmp;
-            mean3 += tmp;
-        }
         printf("\n%d points, sample size = %d\n", MIL, i);
-        mean3 /= i;
-        printf("mean = %10.8f\n", mean3);
-
-        for (j = 0; j < i; j++)
-        {
-            est_var3 += pow(res3[j] - mean3, 2);
-        }
-        est_var3 /= i - 1;
-        printf("estimated variance = %10.8f\n", est_var3);
-        std_dev3 = sqrt(est_var3);
-        printf("standard deviation = %10.8f\n", std_dev3);
-        std_err3 = std_dev3 / sqrt(i);
+        printf("mean = %10.8f\n", reps3.mean);
+        printf("estimated variance = %10.8f\n", welford_var(&reps3));
+        printf("standard deviation = %10.8f\n", sqrt(welford_var(&reps3)));
+        std_err3 = welford_std_err(&reps3);
         printf("standard error = %10.8f\n", std_err3);
-        conf_rads3[i - 2] = std_err3 * t_vals[i - 1];
+        conf_rads3[i - 2] = std_err3 * student_t_quantile(0.975, i - 1);
         printf("confidence radius = %10.8f\n", conf_rads3[i - 2]);
         printf("confidence interval = [%10.8f, %10.8f]\n",
-               mean3 - conf_rads3[i - 2],
-               mean3 + conf_rads3[i - 2]);
+               reps3.mean - conf_rads3[i - 2],
+               reps3.mean + conf_rads3[i - 2]);
     }
 
     for (i = 0; i < SIZE_3_MAX - 1; i++)
@@ -200,5 +870,88 @@ int main(void)
     }
     printf("\n");
 
+    printf("\nNow running replicates only until the 95%% confidence radius falls below a target, "
+           "keeping # of points constant\n");
+    double             targets3[3] = {0.002, 0.001, 0.0005};
+    unsigned long long points3     = MIL;
+    welford            seq3;
+    int                reached3;
+    for (i = 0; i < 3; i++)
+    {
+        reached3 = seq_estimate(simPiReplicate, &points3, targets3[i], 0.95, SEQ_MIN_REPS, SEQ_MAX_REPS, &seq3);
+        printf("\ntarget radius = %10.8f: %s after %llu replicates (%llu points)\n", targets3[i],
+               reached3 ? "reached" : "NOT reached", seq3.n, seq3.n * points3);
+        printf("mean = %10.8f\n", seq3.mean);
+        printf("confidence radius = %10.8f\n", welford_radius(&seq3, 0.95));
+        printf("confidence interval = [%10.8f, %10.8f]\n",
+               seq3.mean - welford_radius(&seq3, 0.95),
+               seq3.mean + welford_radius(&seq3, 0.95));
+    }
+
+    printf("\nNow replacing random points by randomized quasi-random ones (RQMC): %d replicates "
+           "(independent randomizations) each time\n", SIZE_3_MAX);
+    const char *names3[4]     = {"random (MC)", "Sobol, Owen", "Sobol, digital shift", "Halton, shift"};
+    rqmc_job   jobs3[4]       = {{0},
+                                 {QMC_SOBOL, QMC_OWEN, 1, 0},
+                                 {QMC_SOBOL, QMC_SHIFT, 1, 0},
+                                 {QMC_HALTON, QMC_SHIFT, 1, 0}};
+    for (points3 = 1 << 10; points3 <= (1 << 18); points3 <<= 4)
+    {
+        printf("\n%llu points, sample size = %d\n", points3, SIZE_3_MAX);
+        for (j = 0; j < 4; j++)
+        {
+            jobs3[j].points = points3;
+            welford w3 = WELFORD_INIT;
+            for (i = 0; i < SIZE_3_MAX; i++)
+            {
+                welford_add(&w3, j == 0 ? simPi(points3) : simPiReplicate_qmc(&jobs3[j]));
+            }
+            printf("%-20s mean = %10.8f, confidence radius = %10.8f\n", names3[j], w3.mean,
+                   welford_radius(&w3, 0.95));
+        }
+    }
+
+    jobs3[1].points = 1 << 14;
+    for (i = 0; i < 3; i++)
+    {
+        reached3 = seq_estimate(simPiReplicate_qmc, &jobs3[1], targets3[i], 0.95, SEQ_MIN_REPS, SEQ_MAX_REPS, &seq3);
+        printf("\n%s, target radius = %10.8f: %s after %llu replicates (%llu points)\n", names3[1], targets3[i],
+               reached3 ? "reached" : "NOT reached", seq3.n, seq3.n * jobs3[1].points);
+        printf("mean = %10.8f\n", seq3.mean);
+        printf("confidence radius = %10.8f\n", welford_radius(&seq3, 0.95));
+    }
+
+    printf("\nNow reducing the variance of replicates of %d points, sample size = %d: variance reduction factor (VRF) "
+           "against plain MC, and efficiency (VRF per unit of time)\n", VR_POINTS, SIZE_3_MAX);
+    const char        *vrNames3[4] = {"antithetic", "stratified", "LHS", "control"};
+    const vr_estimator vrEst3[4]   = {vr_antithetic, vr_stratified, vr_lhs, vr_control};
+    double             expMean3    = 11.0;
+    vr_problem         pi3         = {quarterDisc, radius2, 2.0 / 3.0, NULL};
+    vr_problem         exp3        = {expInverse, identity, 0.5, &expMean3};
+    printf("\npi (simPi(), control variate x^2 + y^2):\n");
+    vr_report(&pi3, vrNames3, vrEst3, 4, VR_POINTS, SIZE_3_MAX);
+    printf("\nmean of negExp(%.1f) (TP2, control variate u):\n", expMean3);
+    vr_report(&exp3, vrNames3, vrEst3, 4, VR_POINTS, SIZE_3_MAX);
+
+    printf("\nNow integrating over [0, 1[^d (mcint_run(), %d thread(s)): %d replicates of %d points\n",
+           simPi_default_threads(), SIZE_3_MAX, MCINT_POINTS);
+    mcint_result mc3;
+    int          dims3[5] = {2, 3, 5, 8, 12};
+    for (i = 0; i < 5; i++)
+    {
+        mcint_run(nBall, NULL, dims3[i], MCINT_POINTS, SIZE_3_MAX, 0.95, 5489UL, 0, &mc3);
+        printf("volume of the unit %2d-ball = %10.8f +/- %10.8f (standard error %10.8f), exact %10.8f\n", dims3[i],
+               mc3.estimate, mc3.radius, mc3.std_err, pow(M_PI, dims3[i] / 2.0) / tgamma(dims3[i] / 2.0 + 1));
+    }
+    option opt3 = {100.0, 110.0, 0.05, 0.2, 1.0};
+    mcint_run(europeanCall, &opt3, 2, MCINT_POINTS, SIZE_3_MAX, 0.95, 5489UL, 0, &mc3);
+    printf("European call = %10.8f +/- %10.8f, Black-Scholes %10.8f\n", mc3.estimate, mc3.radius,
+           blackScholesCall(&opt3));
+    mcint_run(asianCall, &opt3, ASIAN_DATES, MCINT_POINTS, SIZE_3_MAX, 0.95, 5489UL, 0, &mc3);
+    printf("Asian call, %d dates = %10.8f +/- %10.8f\n", ASIAN_DATES, mc3.estimate, mc3.radius);
+
+    free(g.reps);
+    free(g.gens);
+    free(g.saved);
     return 0;
 }
\ No newline at end of file
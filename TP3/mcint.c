@@ -0,0 +1,164 @@
+//
+// Monte Carlo integration over [0, 1[^d, see mcint.h
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "mcint.h"
+#include "mt.h"
+#include "stats.h"
+
+/* what all threads share: the job, the replicates' streams and means */
+typedef struct mcint_job
+{
+    mcint_fn           f;
+    void               *ctx;
+    int                dim;
+    unsigned long long points;
+    int                reps;
+    int                threads;
+    mt_state           *streams; /* reps of them */
+    double             *means;   /* reps of them */
+} mcint_job;
+
+typedef struct mcint_task
+{
+    mcint_job *job;
+    int       first; /* replicates first, first + threads, ... */
+} mcint_task;
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+static void *allocOrDie(size_t size, size_t align)
+{
+    void *p = align > 0 ? aligned_alloc(align, (size + align - 1) / align * align) : malloc(size);
+
+    if (p == NULL)
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* one thread per online CPU, MCINT_MAX_THREADS at most */
+static int mcintDefaultThreads(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (n < 1) return 1;
+    return n > MCINT_MAX_THREADS ? MCINT_MAX_THREADS : (int) n;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   BUSINESS    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* the means of this task's replicates, batch by batch */
+static void *mcintWorker(void *arg)
+{
+    mcint_task         *task = arg;
+    mcint_job          *job  = task->job;
+    double             *x    = allocOrDie(sizeof(double) * job->dim * MCINT_BATCH, 64);
+    double             *out  = allocOrDie(sizeof(double) * MCINT_BATCH, 64);
+    double             sum, batchSum;
+    unsigned long long done;
+    size_t             n;
+
+    for (int r = task->first; r < job->reps; r += job->threads)
+    {
+        mt_state *st = &job->streams[r];
+
+        sum  = 0.0;
+        done = 0;
+        while (done < job->points)
+        {
+            n = (job->points - done < MCINT_BATCH) ? (size_t) (job->points - done) : MCINT_BATCH;
+            for (int j = 0; j < job->dim; j++)
+            {
+                genrand_fill_real3_r(st, x + (size_t) j * MCINT_BATCH, n);
+            }
+            job->f(x, MCINT_BATCH, n, job->dim, out, job->ctx);
+            batchSum = 0.0;
+            for (size_t k = 0; k < n; k++)
+            {
+                batchSum += out[k];
+            }
+            sum += batchSum;
+            done += n;
+        }
+        job->means[r] = sum / (double) job->points;
+    }
+    free(x);
+    free(out);
+    return NULL;
+}
+
+void mcint_run(mcint_fn f, void *ctx, int inDim, unsigned long long inPoints, int inReps, double inConf,
+               unsigned long inSeed, int inThreads, mcint_result *out)
+{
+    mcint_job  job;
+    mcint_task *tasks;
+    pthread_t  *threads;
+    welford    w = WELFORD_INIT;
+
+    if (inThreads == 0) inThreads = mcintDefaultThreads();
+    if (inThreads < 1) inThreads = 1;
+    if (inDim < 1 || inDim > MCINT_MAX_DIM || inPoints < 1 || inReps < 2 || inThreads > MCINT_MAX_THREADS)
+    {
+        printf("mcint_run: %d dimensions, %llu points, %d replicates, %d threads, expected 1 to %d, 1 or more, "
+               "2 or more, 1 to %d\n", inDim, inPoints, inReps, inThreads, MCINT_MAX_DIM, MCINT_MAX_THREADS);
+        exit(EXIT_FAILURE);
+    }
+    if (inThreads > inReps) inThreads = inReps;
+
+    job.f       = f;
+    job.ctx     = ctx;
+    job.dim     = inDim;
+    job.points  = inPoints;
+    job.reps    = inReps;
+    job.threads = inThreads;
+    job.streams = allocOrDie(sizeof(mt_state) * inReps, 0);
+    job.means   = allocOrDie(sizeof(double) * inReps, 64);
+    tasks       = allocOrDie(sizeof(mcint_task) * inThreads, 0);
+    threads     = allocOrDie(sizeof(pthread_t) * inThreads, 0);
+    mt_substreams_r(job.streams, inReps, inSeed); // one per replicate
+
+    for (int t = 0; t < inThreads; t++)
+    {
+        tasks[t].job   = &job;
+        tasks[t].first = t;
+    }
+    for (int t = 1; t < inThreads; t++)
+    {
+        if (pthread_create(&threads[t], NULL, mcintWorker, &tasks[t]) != 0)
+        {
+            printf("mcint_run: could not start thread %d\n", t);
+            exit(EXIT_FAILURE);
+        }
+    }
+    mcintWorker(&tasks[0]); // the calling thread takes the first share
+    for (int t = 1; t < inThreads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+
+    for (int r = 0; r < inReps; r++)
+    {
+        welford_add(&w, job.means[r]);
+    }
+    out->estimate = w.mean;
+    out->std_err  = welford_std_err(&w);
+    out->radius   = welford_radius(&w, inConf);
+    out->points   = inPoints * (unsigned long long) inReps;
+    out->reps     = inReps;
+
+    free(job.streams);
+    free(job.means);
+    free(tasks);
+    free(threads);
+}
@@ -0,0 +1,72 @@
+//
+// Monte Carlo integration over [0, 1[^d, d up to MCINT_MAX_DIM: simPi() for any integrand.
+//
+// The estimate is the mean of R replicates, each the mean of f over its own points, with the Student-t confidence
+// interval of section 3 (stats.h). Replicate r draws from MT19937 substream r: the sequence seeded by
+// init_genrand(seed), jumped r times by 2^MCINT_JUMP_LOG2 draws. Replicates are shared between threads, and their
+// means reduced in replicate order, so a given seed gives the same result on any number of threads.
+//
+// Points come in batches of MCINT_BATCH, structure of arrays: coordinate j of point k is x[j * stride + k], each
+// coordinate filled by one genrand_fill_real3_r() call (open interval, so that log() or an inverse cdf never sees
+// 0 or 1). The integrand evaluates a whole batch at once: a loop over k, on contiguous x[j * stride + k], which
+// the compiler vectorizes. MCINT_POINTWISE() writes that loop around a per-point expression, inlined.
+//
+
+#ifndef Y2_C_SIM_MCINT_H
+#define Y2_C_SIM_MCINT_H
+
+#include <stddef.h>
+#include "mt.h"
+
+#define MCINT_MAX_DIM 64
+#define MCINT_BATCH 256 // points per batch
+#define MCINT_JUMP_LOG2 MT_SUBSTREAM_LOG2 // distance between two replicates' streams, in draws
+#define MCINT_MAX_THREADS 256
+
+/* integrand: out[k] = f(point k) for k < n, coordinate j of point k being x[j * stride + k] */
+typedef void (*mcint_fn)(const double *x, size_t stride, size_t n, int dim, double *out, void *ctx);
+
+/*
+ * defines mcint_fn name from expr, the integrand at one point, coordinate j being MCINT_X(j);
+ * ctx and dim are in scope, e.g. MCINT_POINTWISE(sum2, MCINT_X(0) + MCINT_X(1))
+ */
+#define MCINT_X(j) x[(size_t) (j) * stride + k]
+#define MCINT_POINTWISE(name, expr)                                                          \
+    static void name(const double *x, size_t stride, size_t n, int dim, double *out, void *ctx) \
+    {                                                                                        \
+        (void) dim;                                                                          \
+        (void) ctx;                                                                          \
+        for (size_t k = 0; k < n; k++)                                                       \
+        {                                                                                    \
+            out[k] = (expr);                                                                 \
+        }                                                                                    \
+    }
+
+typedef struct mcint_result
+{
+    double             estimate; /* mean of the replicates */
+    double             std_err;  /* standard error of said mean */
+    double             radius;   /* confidence radius: the interval is estimate +/- radius */
+    unsigned long long points;   /* in all */
+    int                reps;
+} mcint_result;
+
+/**
+ * mcint_run
+ * integrates f over [0, 1[^inDim
+ * <br>the first call also finds the jump polynomial (a fraction of a second), and each replicate jumps once more
+ * @param f integrand
+ * @param ctx passed to f, shared by all threads (read only)
+ * @param inDim number of dimensions, 1 to MCINT_MAX_DIM
+ * @param inPoints points per replicate
+ * @param inReps number of replicates, 2 or more
+ * @param inConf confidence level of the interval, e.g. 0.95
+ * @param inSeed seed, as for init_genrand()
+ * @param inThreads number of threads (1 to MCINT_MAX_THREADS), 0 for one per online CPU (MCINT_MAX_THREADS at most);
+ * no more than inReps are used
+ * @param out said estimate
+ */
+void mcint_run(mcint_fn f, void *ctx, int inDim, unsigned long long inPoints, int inReps, double inConf,
+               unsigned long inSeed, int inThreads, mcint_result *out);
+
+#endif //Y2_C_SIM_MCINT_H
@@ -43,13 +43,26 @@
    email: m-mat @ math.sci.hiroshima-u.ac.jp (remove space)
 */
 
+#include <string.h>
 #include "mt.h"
 
-static unsigned long mt[N]; /* the array for the state vector  */
-static int           mti = N + 1; /* mti==N+1 means mt[N] is not initialized */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(MT_NO_SIMD)
+#define MT_X86_SIMD
+#include <immintrin.h>
+#endif
 
-void init_genrand(unsigned long s)
+static mt_state mt_global = MT_STATE_INIT; /* state behind the non-reentrant API */
+static int      mt_simd_max = MT_SIMD_AVX2; /* lowered by mt_simd_select() */
+
+/* Tempering constants */
+#define TEMPER_B 0x9d2c5680U
+#define TEMPER_C 0xefc60000U
+
+void init_genrand_r(mt_state *st, unsigned long s)
 {
+    uint32_t *mt = st->mt;
+    int      mti;
+
     mt[0] = s & 0xffffffffUL;
     for (mti = 1; mti < N; mti++)
     {
@@ -59,15 +72,16 @@ void init_genrand(unsigned long s)
         /* In the previous versions, MSBs of the seed affect   */
         /* only MSBs of the array mt[].                        */
         /* 2002/01/09 modified by Makoto Matsumoto             */
-        mt[mti] &= 0xffffffffUL;
-        /* for >32 bit machines */
+        /* (the 32-bit store truncates for >32 bit machines)   */
     }
+    st->mti = mti;
 }
 
-void init_by_array(unsigned long init_key[], int key_length)
+void init_by_array_r(mt_state *st, unsigned long init_key[], int key_length)
 {
-    int i, j, k;
-    init_genrand(19650218UL);
+    uint32_t *mt = st->mt;
+    int      i, j, k;
+    init_genrand_r(st, 19650218UL);
     i = 1;
     j = 0;
     k = (N > key_length ? N : key_length);
@@ -75,7 +89,7 @@ void init_by_array(unsigned long init_key[], int key_length)
     {
         mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 30)) * 1664525UL))
                 + init_key[j] + j; /* non linear */
-        mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
+        /* the 32-bit store truncates for WORDSIZE > 32 machines */
         i++;
         j++;
         if (i >= N)
@@ -89,7 +103,6 @@ void init_by_array(unsigned long init_key[], int key_length)
     {
         mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 30)) * 1566083941UL))
                 - i; /* non linear */
-        mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
         i++;
         if (i >= N)
         {
@@ -101,62 +114,605 @@ void init_by_array(unsigned long init_key[], int key_length)
     mt[0] = 0x80000000UL; /* MSB is 1; assuring non-zero initial array */
 }
 
-unsigned long genrand_int32(void)
+/*
+ * twist kernels: all of them generate the same N words at one time.
+ * -(y & 1) & MATRIX_A replaces the mag01[] lookup of the reference code, so that it vectorizes.
+ * first part (kk < N - M) only reads words that are not rewritten yet,
+ * second part reads mt[kk + M - N], which is at least N - M words behind kk and so already rewritten:
+ * both are safe to process 4 or 8 words at a time.
+ */
+
+static void mt_twist_scalar(uint32_t *mt)
 {
-    unsigned long        y;
-    static unsigned long mag01[2] = {0x0UL, MATRIX_A};
-    /* mag01[x] = x * MATRIX_A  for x=0,1 */
+    uint32_t y;
+    int      kk;
 
-    if (mti >= N)
-    { /* generate N words at one time */
-        int kk;
+    for (kk = 0; kk < N - M; kk++)
+    {
+        y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
+        mt[kk] = mt[kk + M] ^ (y >> 1) ^ (-(y & 0x1U) & MATRIX_A);
+    }
+    for (; kk < N - 1; kk++)
+    {
+        y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
+        mt[kk] = mt[kk + (M - N)] ^ (y >> 1) ^ (-(y & 0x1U) & MATRIX_A);
+    }
+    y = (mt[N - 1] & UPPER_MASK) | (mt[0] & LOWER_MASK);
+    mt[N - 1] = mt[M - 1] ^ (y >> 1) ^ (-(y & 0x1U) & MATRIX_A);
+}
 
-        if (mti == N + 1)   /* if init_genrand() has not been called, */
-            init_genrand(5489UL); /* a default initial seed is used */
+static void mt_temper_scalar(uint32_t *out, const uint32_t *in, int n)
+{
+    uint32_t y;
 
-        for (kk = 0; kk < N - M; kk++)
-        {
-            y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
-            mt[kk] = mt[kk + M] ^ (y >> 1) ^ mag01[y & 0x1UL];
-        }
-        for (; kk < N - 1; kk++)
-        {
-            y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
-            mt[kk] = mt[kk + (M - N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
-        }
-        y = (mt[N - 1] & UPPER_MASK) | (mt[0] & LOWER_MASK);
-        mt[N - 1] = mt[M - 1] ^ (y >> 1) ^ mag01[y & 0x1UL];
+    for (int i = 0; i < n; i++)
+    {
+        y = in[i];
+        y ^= (y >> 11);
+        y ^= (y << 7) & TEMPER_B;
+        y ^= (y << 15) & TEMPER_C;
+        y ^= (y >> 18);
+        out[i] = y;
+    }
+}
+
+#ifdef MT_X86_SIMD
+
+__attribute__((target("sse2")))
+static void mt_twist_sse2(uint32_t *mt)
+{
+    const __m128i upper = _mm_set1_epi32((int) UPPER_MASK);
+    const __m128i lower = _mm_set1_epi32((int) LOWER_MASK);
+    const __m128i matA  = _mm_set1_epi32((int) MATRIX_A);
+    __m128i       y;
+    uint32_t      y_s;
+    int           kk;
+
+    for (kk = 0; kk + 4 <= N - M; kk += 4)
+    {
+        y = _mm_or_si128(_mm_and_si128(_mm_loadu_si128((__m128i *) (mt + kk)), upper),
+                         _mm_and_si128(_mm_loadu_si128((__m128i *) (mt + kk + 1)), lower));
+        _mm_storeu_si128((__m128i *) (mt + kk),
+                         _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128((__m128i *) (mt + kk + M)),
+                                                       _mm_srli_epi32(y, 1)),
+                                         _mm_and_si128(_mm_srai_epi32(_mm_slli_epi32(y, 31), 31), matA)));
+    }
+    for (; kk < N - M; kk++)
+    {
+        y_s = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
+        mt[kk] = mt[kk + M] ^ (y_s >> 1) ^ (-(y_s & 0x1U) & MATRIX_A);
+    }
+    for (; kk + 4 <= N - 1; kk += 4)
+    {
+        y = _mm_or_si128(_mm_and_si128(_mm_loadu_si128((__m128i *) (mt + kk)), upper),
+                         _mm_and_si128(_mm_loadu_si128((__m128i *) (mt + kk + 1)), lower));
+        _mm_storeu_si128((__m128i *) (mt + kk),
+                         _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128((__m128i *) (mt + kk + (M - N))),
+                                                       _mm_srli_epi32(y, 1)),
+                                         _mm_and_si128(_mm_srai_epi32(_mm_slli_epi32(y, 31), 31), matA)));
+    }
+    for (; kk < N - 1; kk++)
+    {
+        y_s = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
+        mt[kk] = mt[kk + (M - N)] ^ (y_s >> 1) ^ (-(y_s & 0x1U) & MATRIX_A);
+    }
+    y_s = (mt[N - 1] & UPPER_MASK) | (mt[0] & LOWER_MASK);
+    mt[N - 1] = mt[M - 1] ^ (y_s >> 1) ^ (-(y_s & 0x1U) & MATRIX_A);
+}
+
+__attribute__((target("avx2")))
+static void mt_twist_avx2(uint32_t *mt)
+{
+    const __m256i upper = _mm256_set1_epi32((int) UPPER_MASK);
+    const __m256i lower = _mm256_set1_epi32((int) LOWER_MASK);
+    const __m256i matA  = _mm256_set1_epi32((int) MATRIX_A);
+    __m256i       y;
+    uint32_t      y_s;
+    int           kk;
+
+    for (kk = 0; kk + 8 <= N - M; kk += 8)
+    {
+        y = _mm256_or_si256(_mm256_and_si256(_mm256_loadu_si256((__m256i *) (mt + kk)), upper),
+                            _mm256_and_si256(_mm256_loadu_si256((__m256i *) (mt + kk + 1)), lower));
+        _mm256_storeu_si256((__m256i *) (mt + kk),
+                            _mm256_xor_si256(_mm256_xor_si256(_mm256_loadu_si256((__m256i *) (mt + kk + M)),
+                                                                 _mm256_srli_epi32(y, 1)),
+                                                _mm256_and_si256(_mm256_srai_epi32(_mm256_slli_epi32(y, 31), 31),
+                                                                 matA)));
+    }
+    for (; kk < N - M; kk++)
+    {
+        y_s = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
+        mt[kk] = mt[kk + M] ^ (y_s >> 1) ^ (-(y_s & 0x1U) & MATRIX_A);
+    }
+    for (; kk + 8 <= N - 1; kk += 8)
+    {
+        y = _mm256_or_si256(_mm256_and_si256(_mm256_loadu_si256((__m256i *) (mt + kk)), upper),
+                            _mm256_and_si256(_mm256_loadu_si256((__m256i *) (mt + kk + 1)), lower));
+        _mm256_storeu_si256((__m256i *) (mt + kk),
+                            _mm256_xor_si256(_mm256_xor_si256(_mm256_loadu_si256((__m256i *) (mt + kk + (M - N))),
+                                                                 _mm256_srli_epi32(y, 1)),
+                                                _mm256_and_si256(_mm256_srai_epi32(_mm256_slli_epi32(y, 31), 31),
+                                                                 matA)));
+    }
+    for (; kk < N - 1; kk++)
+    {
+        y_s = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
+        mt[kk] = mt[kk + (M - N)] ^ (y_s >> 1) ^ (-(y_s & 0x1U) & MATRIX_A);
+    }
+    y_s = (mt[N - 1] & UPPER_MASK) | (mt[0] & LOWER_MASK);
+    mt[N - 1] = mt[M - 1] ^ (y_s >> 1) ^ (-(y_s & 0x1U) & MATRIX_A);
+}
+
+__attribute__((target("sse2")))
+static void mt_temper_sse2(uint32_t *out, const uint32_t *in, int n)
+{
+    const __m128i b = _mm_set1_epi32((int) TEMPER_B);
+    const __m128i c = _mm_set1_epi32((int) TEMPER_C);
+    __m128i       y;
+    int           i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        y = _mm_loadu_si128((__m128i *) (in + i));
+        y = _mm_xor_si128(y, _mm_srli_epi32(y, 11));
+        y = _mm_xor_si128(y, _mm_and_si128(_mm_slli_epi32(y, 7), b));
+        y = _mm_xor_si128(y, _mm_and_si128(_mm_slli_epi32(y, 15), c));
+        y = _mm_xor_si128(y, _mm_srli_epi32(y, 18));
+        _mm_storeu_si128((__m128i *) (out + i), y);
+    }
+    mt_temper_scalar(out + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void mt_temper_avx2(uint32_t *out, const uint32_t *in, int n)
+{
+    const __m256i b = _mm256_set1_epi32((int) TEMPER_B);
+    const __m256i c = _mm256_set1_epi32((int) TEMPER_C);
+    __m256i       y;
+    int           i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        y = _mm256_loadu_si256((__m256i *) (in + i));
+        y = _mm256_xor_si256(y, _mm256_srli_epi32(y, 11));
+        y = _mm256_xor_si256(y, _mm256_and_si256(_mm256_slli_epi32(y, 7), b));
+        y = _mm256_xor_si256(y, _mm256_and_si256(_mm256_slli_epi32(y, 15), c));
+        y = _mm256_xor_si256(y, _mm256_srli_epi32(y, 18));
+        _mm256_storeu_si256((__m256i *) (out + i), y);
+    }
+    mt_temper_scalar(out + i, in + i, n - i);
+}
+
+#endif // MT_X86_SIMD
+
+/* best MT_SIMD_* level both allowed by mt_simd_max and supported by this CPU */
+static int mt_simd_level(void)
+{
+#ifdef MT_X86_SIMD
+    if (mt_simd_max >= MT_SIMD_AVX2 && __builtin_cpu_supports("avx2")) return MT_SIMD_AVX2;
+    if (mt_simd_max >= MT_SIMD_SSE2 && __builtin_cpu_supports("sse2")) return MT_SIMD_SSE2;
+#endif
+    return MT_SIMD_SCALAR;
+}
+
+int mt_simd_select(int max_level)
+{
+    mt_simd_max = max_level;
+    return mt_simd_level();
+}
 
-        mti = 0;
+static void mt_twist(uint32_t *mt)
+{
+    switch (mt_simd_level())
+    {
+#ifdef MT_X86_SIMD
+        case MT_SIMD_AVX2:
+            mt_twist_avx2(mt);
+            break;
+        case MT_SIMD_SSE2:
+            mt_twist_sse2(mt);
+            break;
+#endif
+        default:
+            mt_twist_scalar(mt);
     }
+}
 
-    y = mt[mti++];
+void mt_temper_block(uint32_t *out, const uint32_t *in, int n)
+{
+    switch (mt_simd_level())
+    {
+#ifdef MT_X86_SIMD
+        case MT_SIMD_AVX2:
+            mt_temper_avx2(out, in, n);
+            break;
+        case MT_SIMD_SSE2:
+            mt_temper_sse2(out, in, n);
+            break;
+#endif
+        default:
+            mt_temper_scalar(out, in, n);
+    }
+}
+
+/* makes sure there is at least one untempered word left in the state block */
+static void mt_refill(mt_state *st)
+{
+    if (st->mti >= N)
+    { /* generate N words at one time */
+        if (st->mti == N + 1)   /* if init_genrand() has not been called, */
+            init_genrand_r(st, 5489UL); /* a default initial seed is used */
+
+        mt_twist(st->mt);
+        st->mti = 0;
+    }
+}
+
+unsigned long genrand_int32_r(mt_state *st)
+{
+    uint32_t y;
+
+    mt_refill(st);
+    y = st->mt[st->mti++];
 
     /* Tempering */
     y ^= (y >> 11);
-    y ^= (y << 7) & 0x9d2c5680UL;
-    y ^= (y << 15) & 0xefc60000UL;
+    y ^= (y << 7) & TEMPER_B;
+    y ^= (y << 15) & TEMPER_C;
     y ^= (y >> 18);
 
     return y;
 }
 
-double genrand_real1(void)
+double genrand_real1_r(mt_state *st)
 {
-    return genrand_int32() * (1.0 / 4294967295.0);
+    return genrand_int32_r(st) * (1.0 / 4294967295.0);
     /* divided by 2^32-1 */
 }
 
-double genrand_real2(void)
+double genrand_real2_r(mt_state *st)
 {
-    return genrand_int32() * (1.0 / 4294967296.0);
+    return genrand_int32_r(st) * (1.0 / 4294967296.0);
     /* divided by 2^32 */
 }
 
-double genrand_real3(void)
+double genrand_real3_r(mt_state *st)
 {
-    return (((double) genrand_int32()) + 0.5) * (1.0 / 4294967296.0);
+    return (((double) genrand_int32_r(st)) + 0.5) * (1.0 / 4294967296.0);
     /* divided by 2^32 */
 }
 
-/* These real versions are due to Isaku Wada, 2002/01/09 added */
\ No newline at end of file
+/* These real versions are due to Isaku Wada, 2002/01/09 added */
+
+double genrand_res53_r(mt_state *st)
+{
+    unsigned long a = genrand_int32_r(st) >> 5, b = genrand_int32_r(st) >> 6;
+    return (a * 67108864.0 + b) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * bulk fills: temper straight from the state block into the caller's buffer (or into a
+ * block-sized scratch array for the doubles), one refill at a time, instead of one call per word
+ */
+
+void genrand_fill_u32_r(mt_state *st, uint32_t *buf, size_t n)
+{
+    size_t k;
+
+    while (n > 0)
+    {
+        mt_refill(st);
+        k = (size_t) (N - st->mti);
+        if (k > n) k = n;
+        mt_temper_block(buf, st->mt + st->mti, (int) k);
+        st->mti += (int) k;
+        buf += k;
+        n -= k;
+    }
+}
+
+/* fills buf with n doubles, (u + add) * mul for each next output u */
+static void mt_fill_affine(mt_state *st, double *buf, size_t n, double add, double mul)
+{
+    uint32_t tmp[N];
+    size_t   k;
+
+    while (n > 0)
+    {
+        k = n < N ? n : N;
+        genrand_fill_u32_r(st, tmp, k);
+        for (size_t i = 0; i < k; i++)
+        {
+            buf[i] = ((double) tmp[i] + add) * mul;
+        }
+        buf += k;
+        n -= k;
+    }
+}
+
+void genrand_fill_real1_r(mt_state *st, double *buf, size_t n)
+{
+    mt_fill_affine(st, buf, n, 0.0, 1.0 / 4294967295.0);
+}
+
+void genrand_fill_real2_r(mt_state *st, double *buf, size_t n)
+{
+    mt_fill_affine(st, buf, n, 0.0, 1.0 / 4294967296.0);
+}
+
+void genrand_fill_real3_r(mt_state *st, double *buf, size_t n)
+{
+    mt_fill_affine(st, buf, n, 0.5, 1.0 / 4294967296.0);
+}
+
+void genrand_fill_res53_r(mt_state *st, double *buf, size_t n)
+{
+    uint32_t tmp[N];
+    size_t   k;
+
+    while (n > 0)
+    {
+        k = n < N / 2 ? n : N / 2;
+        genrand_fill_u32_r(st, tmp, 2 * k);
+        for (size_t i = 0; i < k; i++)
+        {
+            buf[i] = ((tmp[2 * i] >> 5) * 67108864.0 + (tmp[2 * i + 1] >> 6)) * (1.0 / 9007199254740992.0);
+        }
+        buf += k;
+        n -= k;
+    }
+}
+
+/* non-reentrant API, kept for the existing callers */
+
+void init_genrand(unsigned long s)
+{
+    init_genrand_r(&mt_global, s);
+}
+
+void init_by_array(unsigned long init_key[], int key_length)
+{
+    init_by_array_r(&mt_global, init_key, key_length);
+}
+
+unsigned long genrand_int32(void)
+{
+    return genrand_int32_r(&mt_global);
+}
+
+double genrand_real1(void)
+{
+    return genrand_real1_r(&mt_global);
+}
+
+double genrand_real2(void)
+{
+    return genrand_real2_r(&mt_global);
+}
+
+double genrand_real3(void)
+{
+    return genrand_real3_r(&mt_global);
+}
+
+void mt_get_global(mt_state *out)
+{
+    *out = mt_global;
+}
+
+void mt_set_global(const mt_state *in)
+{
+    mt_global = *in;
+}
+
+double genrand_res53(void)
+{
+    return genrand_res53_r(&mt_global);
+}
+
+void genrand_fill_u32(uint32_t *buf, size_t n)
+{
+    genrand_fill_u32_r(&mt_global, buf, n);
+}
+
+void genrand_fill_real1(double *buf, size_t n)
+{
+    genrand_fill_real1_r(&mt_global, buf, n);
+}
+
+void genrand_fill_real2(double *buf, size_t n)
+{
+    genrand_fill_real2_r(&mt_global, buf, n);
+}
+
+void genrand_fill_real3(double *buf, size_t n)
+{
+    genrand_fill_real3_r(&mt_global, buf, n);
+}
+
+void genrand_fill_res53(double *buf, size_t n)
+{
+    genrand_fill_res53_r(&mt_global, buf, n);
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------  MT19937-64  ------------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+#define NN MT64_NN
+#define MM 156
+#define MATRIX_A64 0xB5026F5AA96619E9ULL
+#define UM 0xFFFFFFFF80000000ULL /* Most significant 33 bits */
+#define LM 0x7FFFFFFFULL /* Least significant 31 bits */
+
+static mt64_state mt64_global = MT64_STATE_INIT;
+
+void init_genrand64_r(mt64_state *st, uint64_t seed)
+{
+    uint64_t *mt = st->mt;
+
+    mt[0] = seed;
+    for (st->mti = 1; st->mti < NN; st->mti++)
+    {
+        mt[st->mti] = (6364136223846793005ULL * (mt[st->mti - 1] ^ (mt[st->mti - 1] >> 62)) + st->mti);
+    }
+}
+
+void init_by_array64_r(mt64_state *st, uint64_t init_key[], uint64_t key_length)
+{
+    uint64_t *mt = st->mt;
+    uint64_t i, j, k;
+    init_genrand64_r(st, 19650218ULL);
+    i = 1;
+    j = 0;
+    k = (NN > key_length ? NN : key_length);
+    for (; k; k--)
+    {
+        mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 62)) * 3935559000370003845ULL))
+                + init_key[j] + j; /* non linear */
+        i++;
+        j++;
+        if (i >= NN)
+        {
+            mt[0] = mt[NN - 1];
+            i = 1;
+        }
+        if (j >= key_length) j = 0;
+    }
+    for (k = NN - 1; k; k--)
+    {
+        mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 62)) * 2862933555777941757ULL))
+                - i; /* non linear */
+        i++;
+        if (i >= NN)
+        {
+            mt[0] = mt[NN - 1];
+            i = 1;
+        }
+    }
+
+    mt[0] = 1ULL << 63; /* MSB is 1; assuring non-zero initial array */
+}
+
+uint64_t genrand64_int64_r(mt64_state *st)
+{
+    uint64_t *mt = st->mt;
+    uint64_t x;
+    int      i;
+
+    if (st->mti >= NN)
+    { /* generate NN words at one time */
+
+        /* if init_genrand64() has not been called, */
+        /* a default initial seed is used     */
+        if (st->mti == NN + 1)
+            init_genrand64_r(st, 5489ULL);
+
+        for (i = 0; i < NN - MM; i++)
+        {
+            x = (mt[i] & UM) | (mt[i + 1] & LM);
+            mt[i] = mt[i + MM] ^ (x >> 1) ^ (-(x & 1ULL) & MATRIX_A64);
+        }
+        for (; i < NN - 1; i++)
+        {
+            x = (mt[i] & UM) | (mt[i + 1] & LM);
+            mt[i] = mt[i + (MM - NN)] ^ (x >> 1) ^ (-(x & 1ULL) & MATRIX_A64);
+        }
+        x = (mt[NN - 1] & UM) | (mt[0] & LM);
+        mt[NN - 1] = mt[MM - 1] ^ (x >> 1) ^ (-(x & 1ULL) & MATRIX_A64);
+
+        st->mti = 0;
+    }
+
+    x = mt[st->mti++];
+
+    x ^= (x >> 29) & 0x5555555555555555ULL;
+    x ^= (x << 17) & 0x71D67FFFEDA60000ULL;
+    x ^= (x << 37) & 0xFFF7EEE000000000ULL;
+    x ^= (x >> 43);
+
+    return x;
+}
+
+int64_t genrand64_int63_r(mt64_state *st)
+{
+    return (int64_t) (genrand64_int64_r(st) >> 1);
+}
+
+double genrand64_real1_r(mt64_state *st)
+{
+    return (genrand64_int64_r(st) >> 11) * (1.0 / 9007199254740991.0);
+    /* divided by 2^53-1 */
+}
+
+double genrand64_real2_r(mt64_state *st)
+{
+    return (genrand64_int64_r(st) >> 11) * (1.0 / 9007199254740992.0);
+    /* divided by 2^53 */
+}
+
+double genrand64_real3_r(mt64_state *st)
+{
+    return ((genrand64_int64_r(st) >> 12) + 0.5) * (1.0 / 4503599627370496.0);
+    /* divided by 2^52 */
+}
+
+double genrand64_real2_mant_r(mt64_state *st)
+{
+    uint64_t bits = (genrand64_int64_r(st) >> 12) | 0x3FF0000000000000ULL; /* exponent of 1.0 */
+    double   res;
+
+    memcpy(&res, &bits, sizeof(res));
+    return res - 1.0;
+}
+
+void init_genrand64(uint64_t seed)
+{
+    init_genrand64_r(&mt64_global, seed);
+}
+
+void init_by_array64(uint64_t init_key[], uint64_t key_length)
+{
+    init_by_array64_r(&mt64_global, init_key, key_length);
+}
+
+uint64_t genrand64_int64(void)
+{
+    return genrand64_int64_r(&mt64_global);
+}
+
+int64_t genrand64_int63(void)
+{
+    return genrand64_int63_r(&mt64_global);
+}
+
+double genrand64_real1(void)
+{
+    return genrand64_real1_r(&mt64_global);
+}
+
+double genrand64_real2(void)
+{
+    return genrand64_real2_r(&mt64_global);
+}
+
+double genrand64_real3(void)
+{
+    return genrand64_real3_r(&mt64_global);
+}
+
+double genrand64_real2_mant(void)
+{
+    return genrand64_real2_mant_r(&mt64_global);
+}
+
+void mt64_get_global(mt64_state *out)
+{
+    *out = mt64_global;
+}
+
+void mt64_set_global(const mt64_state *in)
+{
+    mt64_global = *in;
+}
@@ -45,6 +45,9 @@
    email: m-mat @ math.sci.hiroshima-u.ac.jp (remove space)
 */
 
+#include <stddef.h>
+#include <stdint.h>
+
 /* Period parameters */
 #define N 624
 #define M 397
@@ -52,6 +55,21 @@
 #define UPPER_MASK 0x80000000UL /* most significant w-r bits */
 #define LOWER_MASK 0x7fffffffUL /* least significant r bits */
 
+/* generator state: one per stream, so each thread can own its own */
+typedef struct mt_state
+{
+    uint32_t mt[N]; /* the array for the state vector, 32 bits per word on every platform */
+    int      mti;   /* mti==N+1 means mt[N] is not initialized */
+} mt_state;
+
+/* static initializer for an unseeded state (seeded with 5489 on first draw) */
+#define MT_STATE_INIT {{0U}, N + 1}
+
+/* refill (twist) kernels, best available one is picked at run time */
+#define MT_SIMD_SCALAR 0
+#define MT_SIMD_SSE2   1
+#define MT_SIMD_AVX2   2
+
 /* initializes mt[N] with a seed */
 void init_genrand(unsigned long s);
 
@@ -75,4 +93,142 @@ double genrand_real3(void);
 
 /* These real versions are due to Isaku Wada, 2002/01/09 added */
 
+/* generates a random number on [0,1) with 53-bit resolution*/
+double genrand_res53(void);
+
+/* bulk versions: fill buf with the next n outputs of the matching function above */
+/* (same sequence as n single calls, copied out of the state block one refill at a time) */
+void genrand_fill_u32(uint32_t *buf, size_t n);
+
+void genrand_fill_real1(double *buf, size_t n);
+
+void genrand_fill_real2(double *buf, size_t n);
+
+void genrand_fill_real3(double *buf, size_t n);
+
+void genrand_fill_res53(double *buf, size_t n);
+
+/* reentrant versions: same algorithms, working on a caller-owned state */
+/* the functions above are thin wrappers around these, on one global state */
+void init_genrand_r(mt_state *st, unsigned long s);
+
+void init_by_array_r(mt_state *st, unsigned long init_key[], int key_length);
+
+unsigned long genrand_int32_r(mt_state *st);
+
+double genrand_real1_r(mt_state *st);
+
+double genrand_real2_r(mt_state *st);
+
+double genrand_real3_r(mt_state *st);
+
+double genrand_res53_r(mt_state *st);
+
+void genrand_fill_u32_r(mt_state *st, uint32_t *buf, size_t n);
+
+void genrand_fill_real1_r(mt_state *st, double *buf, size_t n);
+
+void genrand_fill_real2_r(mt_state *st, double *buf, size_t n);
+
+void genrand_fill_real3_r(mt_state *st, double *buf, size_t n);
+
+void genrand_fill_res53_r(mt_state *st, double *buf, size_t n);
+
+/* copies of the state behind the non-reentrant API, e.g. for checkpoints */
+void mt_get_global(mt_state *out);
+
+void mt_set_global(const mt_state *in);
+
+/* caps the refill/tempering kernels at a given MT_SIMD_* level (e.g. to check them against the scalar one) */
+/* returns the level that will actually be used on this CPU */
+int mt_simd_select(int max_level);
+
+/* tempers n raw state words from in into out (out may alias in) */
+void mt_temper_block(uint32_t *out, const uint32_t *in, int n);
+
+/*
+   MT19937-64, from the 64-bit version by Takuji Nishimura and Makoto Matsumoto (2004/9/29),
+   same licence as above. Same period, one 64-bit word per draw.
+*/
+
+#define MT64_NN 312
+
+typedef struct mt64_state
+{
+    uint64_t mt[MT64_NN]; /* the array for the state vector */
+    int      mti;         /* mti==NN+1 means mt[NN] is not initialized */
+} mt64_state;
+
+#define MT64_STATE_INIT {{0U}, MT64_NN + 1}
+
+/* initializes mt[NN] with a seed */
+void init_genrand64(uint64_t seed);
+
+/* initialize by an array with array-length */
+void init_by_array64(uint64_t init_key[], uint64_t key_length);
+
+/* generates a random number on [0, 2^64-1]-interval */
+uint64_t genrand64_int64(void);
+
+/* generates a random number on [0, 2^63-1]-interval */
+int64_t genrand64_int63(void);
+
+/* generates a random number on [0,1]-real-interval, 53-bit resolution */
+double genrand64_real1(void);
+
+/* generates a random number on [0,1)-real-interval, 53-bit resolution */
+double genrand64_real2(void);
+
+/* generates a random number on (0,1)-real-interval, 52-bit resolution */
+double genrand64_real3(void);
+
+/* generates a random number on [0,1)-real-interval, 52-bit resolution, without an int-to-double conversion: */
+/* the top 52 bits become the mantissa of a double in [1,2), then 1 is subtracted */
+double genrand64_real2_mant(void);
+
+void init_genrand64_r(mt64_state *st, uint64_t seed);
+
+void init_by_array64_r(mt64_state *st, uint64_t init_key[], uint64_t key_length);
+
+uint64_t genrand64_int64_r(mt64_state *st);
+
+int64_t genrand64_int63_r(mt64_state *st);
+
+double genrand64_real1_r(mt64_state *st);
+
+double genrand64_real2_r(mt64_state *st);
+
+double genrand64_real3_r(mt64_state *st);
+
+double genrand64_real2_mant_r(mt64_state *st);
+
+void mt64_get_global(mt64_state *out);
+
+void mt64_set_global(const mt64_state *in);
+
+/* jump-ahead (mt_jump.c) */
+
+/* polynomial of degree < 19937 over GF(2), x^J mod the characteristic polynomial, for a jump of J draws */
+#define MT_POLY_WORDS 312
+#define MT_SUBSTREAM_LOG2 64 /* distance between two substreams of mt_substreams_r(), in draws */
+typedef struct mt_jump_poly
+{
+    uint64_t c[MT_POLY_WORDS]; /* bit i is the coefficient of x^i */
+} mt_jump_poly;
+
+/* prepares a jump of 2^log2_steps draws (e.g. 128); compute it once and share it, it takes a while */
+/* the first call also finds the characteristic polynomial, once whatever the threads */
+void mt_jump_poly_pow2(mt_jump_poly *jp, int log2_steps);
+
+/* advances st by as many draws as jp was prepared for */
+void mt_jump_r(mt_state *st, const mt_jump_poly *jp);
+
+/* dst = base jumped idx times: substream idx, e.g. one per thread, never overlapping the others */
+/* for less than 2^(19937 - log2_steps) draws */
+void mt_substream_r(mt_state *dst, const mt_state *base, int idx, const mt_jump_poly *jp);
+
+/* dst[0..n-1] = substreams 0 to n - 1 of init_genrand_r(seed), 2^MT_SUBSTREAM_LOG2 draws apart: one per thread, */
+/* replicate or process; the jump is found on the first call (a fraction of a second) and kept */
+void mt_substreams_r(mt_state *dst, int n, unsigned long seed);
+
 #endif //Y2_C_SIM_MT_H
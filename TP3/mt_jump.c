@@ -0,0 +1,253 @@
+//
+// Jump-ahead for MT19937: advancing a state by 2^k draws without drawing them.
+//
+// MT19937 is F2-linear: its state (19937 significant bits) moves by a fixed linear map A, whose characteristic
+// polynomial phi has degree 19937. Jumping J draws ahead is applying A^J, and since phi(A) = 0,
+// A^J = p(A) with p = x^J mod phi, a polynomial of degree < 19937 that only has to be computed once per jump size.
+// p(A) is then applied to a state by Horner's rule: 19937 one-word steps, plus one state-wide xor per non-zero
+// coefficient (see Haramoto, Matsumoto, L'Ecuyer et al., "Efficient Jump Ahead for F2-Linear Random Number
+// Generators", 2008).
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mt.h"
+
+#define MEXP 19937 /* degree of phi */
+#define SEQ_LEN (2 * MEXP) /* Berlekamp-Massey needs twice the linear complexity */
+#define SEQ_WORDS ((SEQ_LEN + 63) / 64)
+#define POLY_WORDS (MT_POLY_WORDS + 1) /* phi itself, degree MEXP, has one more coefficient */
+#define PROD_WORDS (2 * MT_POLY_WORDS) /* square of a reduced polynomial */
+
+static uint64_t       phi[POLY_WORDS]; /* characteristic polynomial, bit i is the coefficient of x^i */
+static mt_jump_poly   substream_jump;  /* 2^MT_SUBSTREAM_LOG2 draws, for mt_substreams_r() */
+static pthread_once_t jump_once = PTHREAD_ONCE_INIT; /* both found once, whichever thread asks first */
+
+/*-------------------------------------------------------------------------------*/
+/*-------------------------    GF(2) POLYNOMIALS    -----------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+static int getBit(const uint64_t *p, int i)
+{
+    return (int) ((p[i >> 6] >> (i & 63)) & 1U);
+}
+
+static void flipBit(uint64_t *p, int i)
+{
+    p[i >> 6] ^= (uint64_t) 1U << (i & 63);
+}
+
+/* dst ^= src * x^shift, src having srcWords words, dst being large enough */
+static void xorShifted(uint64_t *dst, const uint64_t *src, int srcWords, int shift)
+{
+    int w = shift >> 6, b = shift & 63;
+
+    if (b == 0)
+    {
+        for (int i = 0; i < srcWords; i++)
+        {
+            dst[i + w] ^= src[i];
+        }
+        return;
+    }
+    for (int i = 0; i < srcWords; i++)
+    {
+        dst[i + w] ^= src[i] << b;
+        dst[i + w + 1] ^= src[i] >> (64 - b);
+    }
+}
+
+/* 64 bits of p starting at bit pos (p being at least (pos + 127) / 64 words long) */
+static uint64_t bitsAt(const uint64_t *p, int pos)
+{
+    int w = pos >> 6, b = pos & 63;
+
+    return b == 0 ? p[w] : (p[w] >> b) | (p[w + 1] << (64 - b));
+}
+
+/*
+ * finds phi with the Berlekamp-Massey algorithm on the lowest output bit of 2 * 19937 draws.
+ * phi being irreducible, any non-zero such bit sequence has phi as its minimal polynomial
+ */
+static void findPhi(void)
+{
+    mt_state st;
+    uint64_t *rev = calloc(SEQ_WORDS + POLY_WORDS + 2, sizeof(uint64_t)); /* sequence, last bit first, zero-padded */
+    uint64_t *c   = calloc(POLY_WORDS + 2, sizeof(uint64_t)); /* connection polynomial C(x) */
+    uint64_t *b   = calloc(POLY_WORDS + 2, sizeof(uint64_t));
+    uint64_t *t   = calloc(POLY_WORDS + 2, sizeof(uint64_t));
+    uint64_t d;
+    int      l    = 0, m = 1, n, i, words;
+
+    if (rev == NULL || c == NULL || b == NULL || t == NULL)
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    init_genrand_r(&st, 5489UL);
+    for (n = 0; n < SEQ_LEN; n++)
+    {
+        if (genrand_int32_r(&st) & 1U) flipBit(rev, SEQ_LEN - 1 - n);
+    }
+
+    flipBit(c, 0);
+    flipBit(b, 0);
+    for (n = 0; n < SEQ_LEN; n++)
+    {
+        /* discrepancy: s[n] + sum_{i=1..l} c_i s[n - i], with s[n - i] = rev[SEQ_LEN - 1 - n + i] */
+        words = l / 64 + 1;
+        d     = 0;
+        for (i = 0; i < words; i++)
+        {
+            d ^= c[i] & bitsAt(rev, SEQ_LEN - 1 - n + 64 * i);
+        }
+        if (__builtin_parityll(d) == 0)
+        {
+            m++;
+        } else if (2 * l <= n)
+        {
+            memcpy(t, c, sizeof(uint64_t) * POLY_WORDS);
+            xorShifted(c, b, POLY_WORDS - m / 64, m);
+            l = n + 1 - l;
+            memcpy(b, t, sizeof(uint64_t) * POLY_WORDS);
+            m = 1;
+        } else
+        {
+            xorShifted(c, b, POLY_WORDS - m / 64, m);
+            m++;
+        }
+    }
+
+    /* phi is the reciprocal of C: phi_j = c_{l - j} */
+    memset(phi, 0, sizeof(phi));
+    for (i = 0; i <= l; i++)
+    {
+        if (getBit(c, i)) flipBit(phi, l - i);
+    }
+
+    free(rev);
+    free(c);
+    free(b);
+    free(t);
+}
+
+/* p = p^2 mod phi, p having degree < MEXP */
+static void squareMod(uint64_t *p)
+{
+    uint64_t prod[PROD_WORDS + 2] = {0};
+    uint64_t lo, hi;
+    int      i;
+
+    /* squaring over GF(2) spreads the bits: coefficient i moves to 2i */
+    for (i = 0; i < MT_POLY_WORDS; i++)
+    {
+        lo = hi = 0;
+        for (int j = 0; j < 32; j++)
+        {
+            lo |= ((p[i] >> j) & 1U) << (2 * j);
+            hi |= ((p[i] >> (j + 32)) & 1U) << (2 * j);
+        }
+        prod[2 * i]     = lo;
+        prod[2 * i + 1] = hi;
+    }
+
+    /* cancelling the coefficients from the top down, with shifted copies of phi */
+    for (i = 2 * (MEXP - 1); i >= MEXP; i--)
+    {
+        if (getBit(prod, i)) xorShifted(prod, phi, POLY_WORDS, i - MEXP);
+    }
+    memcpy(p, prod, sizeof(uint64_t) * MT_POLY_WORDS);
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   JUMP AHEAD   ----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* jp = x^(2^log2_steps) mod phi, phi being known */
+static void powMod(mt_jump_poly *jp, int log2_steps)
+{
+    int k;
+
+    memset(jp->c, 0, sizeof(jp->c));
+    /* x^(2^k) needs no reduction while 2^k < MEXP */
+    for (k = 0; k < log2_steps && (2 << k) < MEXP; k++);
+    flipBit(jp->c, 1 << k);
+    for (; k < log2_steps; k++)
+    {
+        squareMod(jp->c);
+    }
+}
+
+static void initJump(void)
+{
+    findPhi();
+    powMod(&substream_jump, MT_SUBSTREAM_LOG2);
+}
+
+void mt_jump_poly_pow2(mt_jump_poly *jp, int log2_steps)
+{
+    pthread_once(&jump_once, initJump);
+    powMod(jp, log2_steps);
+}
+
+/* one draw ahead on a circular window of the last N words, *oldest being the index of the oldest one */
+static void stepWindow(uint32_t *w, int *oldest)
+{
+    int      i = *oldest;
+    uint32_t y = (w[i] & UPPER_MASK) | (w[(i + 1) % N] & LOWER_MASK);
+
+    w[i]    = w[(i + M) % N] ^ (y >> 1) ^ (-(y & 0x1U) & MATRIX_A);
+    *oldest = (i + 1) % N;
+}
+
+void mt_jump_r(mt_state *st, const mt_jump_poly *jp)
+{
+    uint32_t acc[N] = {0};
+    int      oldest = 0, deg;
+
+    if (st->mti == N + 1) init_genrand_r(st, 5489UL);
+
+    /*
+     * the state block mt[0..N-1] is the window of the last N generated words, mt[0] being the oldest,
+     * the next draw being mt[mti]: jumping the window leaves mti where it is
+     */
+    for (deg = MT_POLY_WORDS * 64 - 1; deg > 0 && !getBit(jp->c, deg); deg--);
+    for (int i = deg; i >= 0; i--)
+    {
+        stepWindow(acc, &oldest);
+        if (getBit(jp->c, i))
+        {
+            for (int j = 0; j < N; j++)
+            {
+                acc[(oldest + j) % N] ^= st->mt[j];
+            }
+        }
+    }
+    for (int j = 0; j < N; j++)
+    {
+        st->mt[j] = acc[(oldest + j) % N];
+    }
+}
+
+void mt_substream_r(mt_state *dst, const mt_state *base, int idx, const mt_jump_poly *jp)
+{
+    *dst = *base;
+    for (int i = 0; i < idx; i++)
+    {
+        mt_jump_r(dst, jp);
+    }
+}
+
+void mt_substreams_r(mt_state *dst, int n, unsigned long seed)
+{
+    pthread_once(&jump_once, initJump);
+    init_genrand_r(&dst[0], seed);
+    for (int i = 1; i < n; i++)
+    {
+        dst[i] = dst[i - 1];
+        mt_jump_r(&dst[i], &substream_jump);
+    }
+}
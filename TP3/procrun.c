@@ -0,0 +1,200 @@
+//
+// Replicates in worker processes, see procrun.h
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "ckpt.h"
+#include "mt.h"
+#include "procrun.h"
+#include "rng.h"
+
+/* one per replicate, in the shared mapping: done is only set once value is written */
+typedef struct proc_slot
+{
+    double value;
+    int    done;
+} proc_slot;
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* worker w of inWorkers: replicates todo[w], todo[w + inWorkers], ... then _exit(), never returning to main() */
+static void procWorker(double (*draw)(void *ctx), void *ctx, const mt_state *streams, const int *todo, int inTodo,
+                       int w, int inWorkers, proc_slot *slots)
+{
+    rng gen;
+    int r;
+
+    for (int i = w; i < inTodo; i += inWorkers)
+    {
+        r          = todo[i];
+        gen.kind   = RNG_MT19937;
+        gen.u.mt   = streams[r];
+        rng_set_global(&gen);
+        slots[r].value = draw(ctx);
+        __atomic_store_n(&slots[r].done, 1, __ATOMIC_RELEASE);
+    }
+    fflush(stdout);
+    _exit(EXIT_SUCCESS); // not exit(): the stdio buffers and atexit() handlers are the parent's
+}
+
+/* writes the finished results to inCkpt if there are more than at the last call: seed, # of replicates, then done
+ * and value of each replicate */
+static void procSave(const char *inCkpt, unsigned long inSeed, const proc_slot *slots, int inReps, uint64_t *saved,
+                     int *savedCount)
+{
+    int count = 0;
+
+    saved[0] = inSeed;
+    saved[1] = (uint64_t) inReps;
+    for (int r = 0; r < inReps; r++)
+    {
+        saved[2 + 2 * r] = __atomic_load_n(&slots[r].done, __ATOMIC_ACQUIRE);
+        saved[3 + 2 * r] = saved[2 + 2 * r] ? dbl_to_u64(slots[r].value) : 0;
+        count += (int) saved[2 + 2 * r];
+    }
+    if (count <= *savedCount) return;
+    if (ckpt_save(inCkpt, NULL, saved, 2 + 2 * inReps) != 0)
+    {
+        printf("proc_run: could not write %s\n", inCkpt);
+        return;
+    }
+    *savedCount = count;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   BUSINESS    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+int proc_run(double (*draw)(void *ctx), void *ctx, int inReps, unsigned long inSeed, int inWorkers,
+             const char *inCkpt, double *out)
+{
+    proc_slot       *slots;
+    mt_state        *streams;
+    pid_t           *pids;
+    int             *todo;
+    uint64_t        *saved    = NULL;
+    int             todoCount, workers, status, lost = 0, savedCount = 0;
+    pid_t           pid;
+    long            cpus;
+    struct timespec pollEvery = {0, PROC_POLL_MS * 1000000L};
+
+    if (inWorkers == 0)
+    {
+        cpus      = sysconf(_SC_NPROCESSORS_ONLN);
+        inWorkers = cpus > PROC_MAX_WORKERS ? PROC_MAX_WORKERS : (int) cpus;
+    }
+    if (inWorkers < 1) inWorkers = 1;
+    if (inReps < 1 || inWorkers > PROC_MAX_WORKERS)
+    {
+        printf("proc_run: %d replicates, %d workers, expected 1 or more, 1 to %d\n", inReps, inWorkers,
+               PROC_MAX_WORKERS);
+        return -1;
+    }
+#ifdef RNG_STATIC
+    if (RNG_STATIC != RNG_MT19937)
+    {
+        printf("proc_run: runs on mt19937 substreams, built with RNG_STATIC=%s\n", rng_name(RNG_STATIC));
+        return -1;
+    }
+#endif
+
+    slots = mmap(NULL, sizeof(proc_slot) * inReps, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (slots == MAP_FAILED)
+    {
+        printf("proc_run: could not map %d result slots\n", inReps);
+        return -1;
+    }
+    streams = malloc(sizeof(mt_state) * inReps);
+    pids    = malloc(sizeof(pid_t) * inWorkers);
+    todo    = malloc(sizeof(int) * inReps);
+    if (inCkpt != NULL) saved = malloc(sizeof(uint64_t) * (2 + 2 * (size_t) inReps));
+    if (streams == NULL || pids == NULL || todo == NULL || (inCkpt != NULL && saved == NULL))
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+    // one substream per replicate; the mapping starts zeroed, so no slot is done but those of the checkpoint
+    mt_substreams_r(streams, inReps, inSeed);
+    if (inCkpt != NULL && ckpt_load(inCkpt, NULL, saved, 2 + 2 * inReps) == 0 && saved[0] == inSeed
+        && saved[1] == (uint64_t) inReps)
+    {
+        for (int r = 0; r < inReps; r++)
+        {
+            slots[r].done  = saved[2 + 2 * r] != 0;
+            slots[r].value = u64_to_dbl(saved[3 + 2 * r]);
+            savedCount += slots[r].done;
+        }
+        printf("(resuming from %s: %d replicates done)\n", inCkpt, savedCount);
+    }
+
+    for (int round = 0; round < PROC_ROUNDS; round++)
+    {
+        todoCount = 0;
+        for (int r = 0; r < inReps; r++)
+        {
+            if (!slots[r].done) todo[todoCount++] = r;
+        }
+        if (todoCount == 0) break;
+        if (round > 0) printf("proc_run: running %d lost replicate(s) again\n", todoCount);
+
+        workers = inWorkers < todoCount ? inWorkers : todoCount;
+        fflush(stdout);
+        for (int w = 0; w < workers; w++)
+        {
+            pids[w] = fork();
+            if (pids[w] < 0)
+            {
+                printf("proc_run: could not start worker %d\n", w);
+                workers = w; // the replicates of the others are lost, for this round
+                break;
+            }
+            if (pids[w] == 0) procWorker(draw, ctx, streams, todo, todoCount, w, workers, slots);
+        }
+        for (int w = 0; w < workers; w++)
+        {
+            // checkpointing: polls the worker, saving what the others have finished in between
+            while (inCkpt != NULL && (pid = waitpid(pids[w], &status, WNOHANG)) == 0)
+            {
+                procSave(inCkpt, inSeed, slots, inReps, saved, &savedCount);
+                nanosleep(&pollEvery, NULL);
+            }
+            if ((inCkpt == NULL ? waitpid(pids[w], &status, 0) : pid) < 0)
+            {
+                printf("proc_run: lost track of worker %d\n", w);
+            } else if (WIFSIGNALED(status))
+            {
+                printf("proc_run: worker %d killed by signal %d\n", w, WTERMSIG(status));
+            } else if (WIFEXITED(status) && WEXITSTATUS(status) != EXIT_SUCCESS)
+            {
+                printf("proc_run: worker %d exited with status %d\n", w, WEXITSTATUS(status));
+            }
+        }
+    }
+
+    for (int r = 0; r < inReps; r++)
+    {
+        out[r] = slots[r].done ? slots[r].value : NAN;
+        lost += !slots[r].done;
+    }
+    if (lost > 0) printf("proc_run: %d replicate(s) could not be run\n", lost);
+    if (inCkpt != NULL)
+    {
+        if (lost > 0) procSave(inCkpt, inSeed, slots, inReps, saved, &savedCount); // keeps the others
+        else remove(inCkpt);
+    }
+
+    munmap(slots, sizeof(proc_slot) * inReps);
+    free(streams);
+    free(pids);
+    free(todo);
+    free(saved);
+    return lost > 0 ? -1 : 0;
+}
@@ -0,0 +1,47 @@
+//
+// Replicates in worker processes: fork()ed workers instead of threads, for crash isolation, per-process memory
+// (NUMA locality, no shared allocator) and a global generator each.
+//
+// Replicate r runs on MT19937 substream r: the sequence seeded by init_genrand(seed), jumped r times by
+// 2^PROC_JUMP_LOG2 draws, set as the worker's global generator before calling draw(), so that code written for the
+// global generator (simPi(), say) runs unchanged. Worker w of N takes replicates w, w + N, ... and writes each result
+// to its slot of a shared anonymous mapping; the parent reads them once the workers are done. A result depends on
+// its replicate only: any number of workers, or a rerun, gives the same ones.
+//
+// A worker that dies (signal, exit status) loses the replicates it had not written yet: they are run again by a new
+// round of workers, PROC_ROUNDS rounds in all.
+//
+// Given a checkpoint file, the parent also writes the finished results to it every PROC_POLL_MS while it waits (see
+// ckpt.h, payload only): a rerun after the whole program was stopped only runs the others.
+//
+
+#ifndef Y2_C_SIM_PROCRUN_H
+#define Y2_C_SIM_PROCRUN_H
+
+#include "mt.h"
+
+#define PROC_JUMP_LOG2 MT_SUBSTREAM_LOG2 // distance between two replicates' streams, in draws
+#define PROC_MAX_WORKERS 256
+#define PROC_ROUNDS 2
+#define PROC_POLL_MS 200 // how often the parent checks for new results to checkpoint
+
+/**
+ * proc_run
+ * runs inReps replicates of draw over inWorkers worker processes
+ * <br>the first call also finds the jump polynomial (a fraction of a second), and each replicate jumps once more;
+ * stdout is flushed before forking, so that buffered output is not printed twice
+ * @param draw one replicate, on the global generator (as for seq_estimate())
+ * @param ctx passed to draw
+ * @param inReps number of replicates
+ * @param inSeed seed, as for init_genrand()
+ * @param inWorkers number of workers (1 to PROC_MAX_WORKERS), 0 for one per online CPU (PROC_MAX_WORKERS at most);
+ * no more than inReps are used
+ * @param inCkpt checkpoint file, removed once every replicate is done, NULL for none; one per call (draw and ctx
+ * are not in it, only inSeed and inReps are checked on resuming)
+ * @param out inReps results, in replicate order
+ * @return 0 if successful, -1 if some replicates could not be run (their out[] is then NAN)
+ */
+int proc_run(double (*draw)(void *ctx), void *ctx, int inReps, unsigned long inSeed, int inWorkers,
+             const char *inCkpt, double *out);
+
+#endif //Y2_C_SIM_PROCRUN_H
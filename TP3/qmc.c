@@ -0,0 +1,188 @@
+//
+// Quasi-Monte Carlo point sets, see qmc.h
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "qmc.h"
+#include "rng.h"
+
+/*
+ * Sobol direction numbers of Joe & Kuo, "Constructing Sobol sequences with better two-dimensional projections"
+ * (2008), file new-joe-kuo-6.21201, dimensions 2 to 16 (dimension 1 is van der Corput's sequence):
+ * degree s and coefficients a of the primitive polynomial, initial direction numbers m_1 to m_s
+ */
+static const struct
+{
+    int      s;
+    int      a;
+    uint32_t m[6];
+} joe_kuo[QMC_MAX_DIM - 1] =
+        {
+                {1, 0,  {1}},
+                {2, 1,  {1, 3}},
+                {3, 1,  {1, 3, 1}},
+                {3, 2,  {1, 1, 1}},
+                {4, 1,  {1, 1, 3, 3}},
+                {4, 4,  {1, 3, 5, 13}},
+                {5, 2,  {1, 1, 5, 5, 17}},
+                {5, 4,  {1, 1, 5, 5, 5}},
+                {5, 7,  {1, 1, 7, 11, 19}},
+                {5, 11, {1, 1, 5, 1, 1}},
+                {5, 13, {1, 1, 1, 3, 11}},
+                {5, 14, {1, 3, 5, 5, 31}},
+                {6, 1,  {1, 3, 3, 9, 7, 49}},
+                {6, 13, {1, 1, 1, 15, 21, 21}},
+                {6, 16, {1, 3, 1, 13, 27, 49}},
+        };
+
+static const int halton_bases[QMC_MAX_DIM] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53};
+
+static uint32_t       sobol_v[QMC_MAX_DIM][QMC_BITS]; /* direction numbers v_1 to v_32, as 32-bit fractions */
+static pthread_once_t sobol_once = PTHREAD_ONCE_INIT; /* filled once, whichever thread asks first */
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* the recurrence of Bratley & Fox on the direction numbers, for each dimension */
+static void sobolInit(void)
+{
+    int      s, a;
+    uint32_t v;
+
+    for (int i = 0; i < QMC_BITS; i++)
+    {
+        sobol_v[0][i] = 1U << (QMC_BITS - 1 - i);
+    }
+    for (int d = 1; d < QMC_MAX_DIM; d++)
+    {
+        s = joe_kuo[d - 1].s;
+        a = joe_kuo[d - 1].a;
+        for (int i = 0; i < s; i++)
+        {
+            sobol_v[d][i] = joe_kuo[d - 1].m[i] << (QMC_BITS - 1 - i);
+        }
+        for (int i = s; i < QMC_BITS; i++)
+        {
+            v = sobol_v[d][i - s] ^ (sobol_v[d][i - s] >> s);
+            for (int k = 1; k < s; k++)
+            {
+                if ((a >> (s - 1 - k)) & 1) v ^= sobol_v[d][i - k];
+            }
+            sobol_v[d][i] = v;
+        }
+    }
+}
+
+static uint32_t reverseBits(uint32_t x)
+{
+    x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+    x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fU) | ((x & 0x0f0f0f0fU) << 4);
+    x = ((x >> 8) & 0x00ff00ffU) | ((x & 0x00ff00ffU) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+/*
+ * nested uniform scrambling of a 32-bit fraction (Burley, "Practical Hash-based Owen Scrambling", 2020):
+ * the Laine-Karras hash, on the reversed bits, only lets each bit depend on the bits above it,
+ * which is what Owen's random permutations of the elementary intervals are
+ */
+static uint32_t owenScramble(uint32_t x, uint32_t seed)
+{
+    x = reverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cU;
+    x ^= x * 0xb82f1e52U;
+    x ^= x * 0xc7afe638U;
+    x ^= x * 0x8d22f6e6U;
+    return reverseBits(x);
+}
+
+/* radical inverse of i in base b: its digits mirrored around the point */
+static double radicalInverse(uint64_t i, int b)
+{
+    double inv = 1.0 / b, f = inv, r = 0.0;
+
+    while (i > 0)
+    {
+        r += (double) (i % b) * f;
+        i /= b;
+        f *= inv;
+    }
+    return r;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   BUSINESS    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+void qmc_init(qmc *q, int inKind, int inDim, int inScramble, uint64_t inSeed)
+{
+    splitmix64_state sm = {inSeed};
+
+    if ((inKind != QMC_SOBOL && inKind != QMC_HALTON) || inDim < 1 || inDim > QMC_MAX_DIM
+        || inScramble < QMC_PLAIN || inScramble > QMC_OWEN || (inKind == QMC_HALTON && inScramble == QMC_OWEN))
+    {
+        printf("qmc_init: unsupported sequence %d, %d dimensions, randomization %d\n", inKind, inDim, inScramble);
+        exit(EXIT_FAILURE);
+    }
+    pthread_once(&sobol_once, sobolInit);
+
+    q->kind     = inKind;
+    q->scramble = inScramble;
+    q->dim      = inDim;
+    q->index    = 0;
+    for (int d = 0; d < QMC_MAX_DIM; d++)
+    {
+        q->x[d]     = 0;
+        q->seed[d]  = 0;
+        q->shift[d] = 0.0;
+        if (inScramble != QMC_PLAIN && d < inDim)
+        {
+            q->seed[d]  = (uint32_t) (splitmix64_next(&sm) >> 32);
+            q->shift[d] = q->seed[d] * (1.0 / 4294967296.0);
+        }
+    }
+}
+
+void qmc_fill(qmc *q, double *buf, size_t n)
+{
+    uint32_t x;
+    double   u;
+    int      c;
+
+    for (size_t k = 0; k < n; k++, q->index++)
+    {
+        if (q->kind == QMC_SOBOL && q->index >> QMC_BITS)
+        {
+            printf("qmc_fill: Sobol sequence exhausted (2^%d points)\n", QMC_BITS);
+            exit(EXIT_FAILURE);
+        }
+        for (int d = 0; d < q->dim; d++)
+        {
+            if (q->kind == QMC_SOBOL)
+            {
+                x = q->x[d];
+                if (q->scramble == QMC_SHIFT) x ^= q->seed[d];
+                if (q->scramble == QMC_OWEN) x = owenScramble(x, q->seed[d]);
+                buf[k * q->dim + d] = x * (1.0 / 4294967296.0);
+            } else
+            {
+                u = radicalInverse(q->index, halton_bases[d]) + q->shift[d];
+                buf[k * q->dim + d] = u >= 1.0 ? u - 1.0 : u;
+            }
+        }
+        if (q->kind == QMC_SOBOL)
+        {
+            // Gray code order: the next point differs from this one by the direction number of the lowest 0 bit
+            c = __builtin_ctzll(~q->index);
+            for (int d = 0; d < q->dim && c < QMC_BITS; d++)
+            {
+                q->x[d] ^= sobol_v[d][c];
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+//
+// Quasi-Monte Carlo point sets over [0, 1[^d: Sobol and Halton sequences, plain or randomized.
+//
+// Low-discrepancy points fill the unit cube far more evenly than random ones: integration errors shrink close to
+// O(1 / N) instead of O(1 / sqrt(N)) for smooth integrands (O(N^-3/4) for the indicator function of simPi()).
+// Plain sequences are deterministic, hence no variance and no confidence interval. Randomized ones (RQMC) are:
+// each randomization (seed) gives an unbiased estimate, so R randomizations are R independent replicates,
+// whose mean and Student-t confidence interval are those of section 3.
+//
+// Randomizations:
+//   QMC_SHIFT  Sobol: digital shift (xor with a random word per dimension), Halton: random shift modulo 1
+//   QMC_OWEN   Sobol only: nested uniform (Owen) scrambling, by Burley's hash-based method (2020); keeps the
+//              net properties of the sequence, and further improves convergence for smooth integrands
+//
+
+#ifndef Y2_C_SIM_QMC_H
+#define Y2_C_SIM_QMC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define QMC_MAX_DIM 16
+#define QMC_BITS 32
+
+/* sequences */
+#define QMC_SOBOL  0
+#define QMC_HALTON 1
+
+/* randomizations */
+#define QMC_PLAIN 0
+#define QMC_SHIFT 1
+#define QMC_OWEN  2
+
+typedef struct qmc
+{
+    int      kind;       /* QMC_SOBOL, QMC_HALTON */
+    int      scramble;   /* QMC_PLAIN, QMC_SHIFT, QMC_OWEN */
+    int      dim;
+    uint64_t index;      /* of the next point */
+    uint32_t x[QMC_MAX_DIM];                 /* Sobol: current point (before randomization), 32-bit fractions */
+    uint32_t seed[QMC_MAX_DIM];              /* per dimension: xor shift, or Owen scrambling seed */
+    double   shift[QMC_MAX_DIM];             /* Halton: shift modulo 1 */
+} qmc;
+
+/**
+ * qmc_init
+ * starts a sequence from its first point (the origin, when plain)
+ * @param q said sequence
+ * @param inKind QMC_SOBOL, QMC_HALTON
+ * @param inDim number of dimensions, 1 to QMC_MAX_DIM
+ * @param inScramble QMC_PLAIN, QMC_SHIFT, QMC_OWEN (Sobol only)
+ * @param inSeed randomization seed, ignored when plain: one seed, one replicate
+ */
+void qmc_init(qmc *q, int inKind, int inDim, int inScramble, uint64_t inSeed);
+
+/**
+ * qmc_fill
+ * next n points, point k being buf[k * dim] to buf[k * dim + dim - 1]
+ * <br>Sobol points are generated in Gray code order (as Joe & Kuo, or scipy): the first 2^m points, for any m,
+ * are a (t, m, d)-net
+ * @param q sequence
+ * @param buf n * dim doubles, in [0, 1[
+ * @param n number of points
+ */
+void qmc_fill(qmc *q, double *buf, size_t n);
+
+#endif //Y2_C_SIM_QMC_H
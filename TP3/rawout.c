@@ -0,0 +1,222 @@
+//
+// Raw generator output, for external test batteries (PractRand, TestU01's batteries on a file, dieharder -g 200...)
+//
+// usage: ./rawout [engine [seed [bytes [file]]]]
+//   engine  one of the rng.h engines, default mt19937
+//   seed    as in rng_seed(), default 5489
+//   bytes   how much to write (k, M, G suffixes: powers of 2), default 0: until the reader closes the stream
+//   file    default stdout
+// e.g.: ./rawout xoshiro256** 42 | RNG_test stdin64
+//
+// The words are written in native byte order, 32 bits at a time for mt19937 and philox4x32, 64 bits for the others.
+// When stdout is a pipe, the buffers are handed over with vmsplice() instead of being copied by write().
+//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "mt.h"
+#include "rng.h"
+
+#define BUF_BYTES (1U << 20) // per buffer, two of them
+#define BUF_WORDS (BUF_BYTES / sizeof(uint64_t))
+
+static uint64_t bufs[2][BUF_WORDS] __attribute__((aligned(4096))); // page-aligned for vmsplice()
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [engine [seed [bytes [file]]]], engine being one of:", prog);
+    for (int i = 0; i < RNG_KINDS; i++)
+    {
+        fprintf(stderr, " %s", rng_name(i));
+    }
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+/* "123", "64k", "10M", "2G"... */
+static unsigned long long parseBytes(const char *str, const char *prog)
+{
+    char               *end;
+    unsigned long long n = strtoull(str, &end, 0);
+
+    switch (*end)
+    {
+        case 'k': case 'K':
+            n <<= 10;
+            end++;
+            break;
+        case 'm': case 'M':
+            n <<= 20;
+            end++;
+            break;
+        case 'g': case 'G':
+            n <<= 30;
+            end++;
+            break;
+    }
+    if (*end != '\0') usage(prog);
+    return n;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   BUSINESS    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/**
+ * fillBuf
+ * fills buf with the next generator output, through the bulk paths where there are some
+ * @param r generator
+ * @param buf BUF_BYTES long
+ * @param philoxNext next word of the philox stream (philox4x32 only)
+ */
+static void fillBuf(rng *r, uint64_t *buf, uint64_t *philoxNext)
+{
+    size_t i;
+
+    switch (r->kind)
+    {
+        case RNG_MT19937:
+            genrand_fill_u32_r(&r->u.mt, (uint32_t *) buf, BUF_BYTES / 4);
+            break;
+        case RNG_PHILOX4X32:
+            philox_fill_u32((uint64_t) r->u.philox.key[1] << 32 | r->u.philox.key[0], r->u.philox.stream, *philoxNext,
+                            (uint32_t *) buf, BUF_BYTES / 4);
+            *philoxNext += BUF_BYTES / 4;
+            break;
+        case RNG_MT19937_64:
+            for (i = 0; i < BUF_WORDS; i++)
+            {
+                buf[i] = genrand64_int64_r(&r->u.mt64);
+            }
+            break;
+        case RNG_XOSHIRO256SS:
+            for (i = 0; i < BUF_WORDS; i++)
+            {
+                buf[i] = xoshiro256ss_next(&r->u.xoshiro);
+            }
+            break;
+        case RNG_PCG64:
+            for (i = 0; i < BUF_WORDS; i++)
+            {
+                buf[i] = pcg64_next(&r->u.pcg);
+            }
+            break;
+        default:
+            for (i = 0; i < BUF_WORDS; i++)
+            {
+                buf[i] = splitmix64_next(&r->u.splitmix);
+            }
+    }
+}
+
+/* write()s len bytes; 0, or -1 once the reader is gone */
+static int writeAll(int fd, const char *p, size_t len)
+{
+    ssize_t k;
+
+    while (len > 0)
+    {
+        k = write(fd, p, len);
+        if (k < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += k;
+        len -= (size_t) k;
+    }
+    return 0;
+}
+
+/*
+ * vmsplice()s len bytes into a pipe: the pipe then references the pages instead of copying them, so a buffer
+ * must not be refilled before the reader has consumed it. With the pipe exactly one (page-aligned) buffer long,
+ * the other buffer being handed over in full means that this one has been read, which is why there are two of them.
+ */
+static int spliceAll(int fd, const char *p, size_t len)
+{
+    struct iovec iov;
+    ssize_t      k;
+
+    while (len > 0)
+    {
+        iov.iov_base = (void *) p;
+        iov.iov_len  = len;
+        k = vmsplice(fd, &iov, 1, 0);
+        if (k < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += k;
+        len -= (size_t) k;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------     MAIN      -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    int                kind    = (argc > 1) ? rng_kind_from_name(argv[1]) : RNG_MT19937;
+    uint64_t           seed    = (argc > 2) ? strtoull(argv[2], NULL, 0) : 5489ULL;
+    unsigned long long left    = (argc > 3) ? parseBytes(argv[3], argv[0]) : 0;
+    int                forever = left == 0, fd = STDOUT_FILENO, splice = 0, cur = 0, err;
+    uint64_t           philoxNext = 0;
+    size_t             len;
+    struct stat        sb;
+    rng                r;
+
+    if (kind < 0 || argc > 5) usage(argv[0]);
+    if (argc > 4)
+    {
+        fd = open(argv[4], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            perror(argv[4]);
+            return EXIT_FAILURE;
+        }
+    }
+    rng_seed(&r, kind, seed);
+    signal(SIGPIPE, SIG_IGN); // a reader closing the stream is the normal way out, see EPIPE below
+
+    if (fstat(fd, &sb) == 0 && S_ISFIFO(sb.st_mode))
+    {
+        splice = fcntl(fd, F_SETPIPE_SZ, BUF_BYTES) == (int) BUF_BYTES;
+    }
+
+    while (forever || left > 0)
+    {
+        fillBuf(&r, bufs[cur], &philoxNext);
+        len = (!forever && left < BUF_BYTES) ? (size_t) left : BUF_BYTES;
+        err = splice ? spliceAll(fd, (const char *) bufs[cur], len) : writeAll(fd, (const char *) bufs[cur], len);
+        if (err)
+        {
+            if (errno == EPIPE) break; // the test battery has seen enough
+            perror("rawout");
+            return EXIT_FAILURE;
+        }
+        left -= forever ? 0 : len;
+        cur ^= 1;
+    }
+    if (fd != STDOUT_FILENO && close(fd) != 0)
+    {
+        perror(argv[4]);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
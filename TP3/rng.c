@@ -0,0 +1,475 @@
+//
+// Generator backends, see rng.h
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rng.h"
+
+static const char *rng_names[RNG_KINDS] = {"mt19937", "mt19937-64", "xoshiro256**", "pcg64", "splitmix64",
+                                                "philox4x32"};
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    HANDLES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* pcg64_srandom_r() of the reference implementation: initstate and initseq on 128 bits */
+static void pcg64_seed(pcg64_state *st, uint64_t state_hi, uint64_t state_lo, uint64_t seq_hi, uint64_t seq_lo)
+{
+    uint64_t lo;
+
+    st->state_hi = st->state_lo = 0;
+    st->inc_hi   = (seq_hi << 1) | (seq_lo >> 63);
+    st->inc_lo   = (seq_lo << 1) | 1U;
+    pcg64_step(st);
+    lo = st->state_lo;
+    st->state_lo += state_lo;
+    st->state_hi += state_hi + (st->state_lo < lo);
+    pcg64_step(st);
+}
+
+void rng_seed(rng *r, int kind, uint64_t seed)
+{
+    splitmix64_state sm = {seed};
+    uint64_t         a, b, c, d;
+
+    r->kind = kind;
+    switch (kind)
+    {
+        case RNG_MT19937:
+            init_genrand_r(&r->u.mt, (unsigned long) (seed & 0xffffffffUL));
+            break;
+        case RNG_MT19937_64:
+            init_genrand64_r(&r->u.mt64, seed);
+            break;
+        case RNG_XOSHIRO256SS:
+            /* seeding through SplitMix64, as advised by the authors: never an all-zero state */
+            for (int i = 0; i < 4; i++)
+            {
+                r->u.xoshiro.s[i] = splitmix64_next(&sm);
+            }
+            break;
+        case RNG_PCG64:
+            a = splitmix64_next(&sm);
+            b = splitmix64_next(&sm);
+            c = splitmix64_next(&sm);
+            d = splitmix64_next(&sm);
+            pcg64_seed(&r->u.pcg, a, b, c, d);
+            break;
+        case RNG_SPLITMIX64:
+            r->u.splitmix.s = seed;
+            break;
+        case RNG_PHILOX4X32:
+            rng_seed_philox(r, seed, 0);
+            break;
+        default:
+            printf("rng_seed: unknown generator kind %d\n", kind);
+            exit(EXIT_FAILURE);
+    }
+}
+
+void rng_seed_philox(rng *r, uint64_t key, uint64_t stream)
+{
+    r->kind            = RNG_PHILOX4X32;
+    r->u.philox.key[0] = (uint32_t) key;
+    r->u.philox.key[1] = (uint32_t) (key >> 32);
+    r->u.philox.stream = stream;
+    r->u.philox.block  = 0;
+    r->u.philox.idx    = 4;
+}
+
+const char *rng_name(int kind)
+{
+    return (kind >= 0 && kind < RNG_KINDS) ? rng_names[kind] : "?";
+}
+
+int rng_kind_from_name(const char *name)
+{
+    for (int i = 0; i < RNG_KINDS; i++)
+    {
+        if (strcmp(name, rng_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+void rng_use_args(int argc, char **argv)
+{
+    int kind;
+
+    if (argc < 2) return;
+    kind = rng_kind_from_name(argv[1]);
+    if (kind < 0)
+    {
+        printf("usage: %s [engine [seed]], engine being one of:", argv[0]);
+        for (int i = 0; i < RNG_KINDS; i++)
+        {
+            printf(" %s", rng_names[i]);
+        }
+        printf("\n");
+        exit(EXIT_FAILURE);
+    }
+    rng_use(kind, argc > 2 ? strtoull(argv[2], NULL, 0) : 5489ULL);
+    printf("(generator: %s)\n", rng_name(kind));
+}
+
+uint64_t rng_u64_r(rng *r)
+{
+    uint64_t hi;
+
+    switch (r->kind)
+    {
+        case RNG_MT19937:
+            hi = genrand_int32_r(&r->u.mt); /* drawn first */
+            return (hi << 32) | genrand_int32_r(&r->u.mt);
+        case RNG_MT19937_64:
+            return genrand64_int64_r(&r->u.mt64);
+        case RNG_XOSHIRO256SS:
+            return xoshiro256ss_next(&r->u.xoshiro);
+        case RNG_PCG64:
+            return pcg64_next(&r->u.pcg);
+        case RNG_PHILOX4X32:
+            return philox4x32_next(&r->u.philox);
+        default:
+            return splitmix64_next(&r->u.splitmix);
+    }
+}
+
+uint32_t rng_u32_r(rng *r)
+{
+    if (r->kind == RNG_MT19937) return (uint32_t) genrand_int32_r(&r->u.mt);
+    if (r->kind == RNG_PHILOX4X32) return philox4x32_next32(&r->u.philox);
+    return (uint32_t) (rng_u64_r(r) >> 32);
+}
+
+double rng_real1_r(rng *r)
+{
+    if (r->kind == RNG_MT19937) return genrand_real1_r(&r->u.mt);
+    return u64_to_real1(rng_u64_r(r));
+}
+
+double rng_real2_r(rng *r)
+{
+    if (r->kind == RNG_MT19937) return genrand_real2_r(&r->u.mt);
+    return u64_to_real2(rng_u64_r(r));
+}
+
+double rng_real3_r(rng *r)
+{
+    if (r->kind == RNG_MT19937) return genrand_real3_r(&r->u.mt);
+    return u64_to_real3(rng_u64_r(r));
+}
+
+void philox_fill_u32(uint64_t key, uint64_t stream, uint64_t first, uint32_t *buf, size_t n)
+{
+    uint32_t k[2]   = {(uint32_t) key, (uint32_t) (key >> 32)};
+    uint32_t ctr[4] = {0, 0, (uint32_t) stream, (uint32_t) (stream >> 32)};
+    uint32_t out[4];
+    uint64_t block  = first / 4;
+    size_t   i      = 0;
+    int      skip   = (int) (first % 4); /* words of the first block before first */
+
+    while (i < n)
+    {
+        ctr[0] = (uint32_t) block;
+        ctr[1] = (uint32_t) (block >> 32);
+        if (skip == 0 && n - i >= 4)
+        {
+            philox4x32_10(ctr, k, buf + i);
+            i += 4;
+        } else
+        {
+            philox4x32_10(ctr, k, out);
+            for (int j = skip; j < 4 && i < n; j++)
+            {
+                buf[i++] = out[j];
+            }
+            skip = 0;
+        }
+        block++;
+    }
+}
+
+void philox_fill_real1(uint64_t key, uint64_t stream, uint64_t first, double *buf, size_t n)
+{
+    uint32_t tmp[1024];
+    size_t   k;
+
+    while (n > 0)
+    {
+        k = n < 1024 ? n : 1024;
+        philox_fill_u32(key, stream, first, tmp, k);
+        for (size_t i = 0; i < k; i++)
+        {
+            buf[i] = tmp[i] * (1.0 / 4294967295.0); /* as genrand_real1() */
+        }
+        first += k;
+        buf += k;
+        n -= k;
+    }
+}
+
+void rng_fill_real1_r(rng *r, double *buf, size_t n)
+{
+    if (r->kind == RNG_MT19937)
+    {
+        genrand_fill_real1_r(&r->u.mt, buf, n);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        buf[i] = rng_real1_r(r);
+    }
+}
+
+/* xoshiro256** jump(): 2^128 draws ahead, with the polynomial of the reference implementation */
+static void xoshiro256Jump(xoshiro256_state *st)
+{
+    static const uint64_t jump[4] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL,
+                                     0x39abdc4529b1661cULL};
+    uint64_t              t[4]    = {0};
+
+    for (int i = 0; i < 4; i++)
+    {
+        for (int b = 0; b < 64; b++)
+        {
+            if (jump[i] & ((uint64_t) 1U << b))
+            {
+                for (int j = 0; j < 4; j++) t[j] ^= st->s[j];
+            }
+            xoshiro256ss_next(st);
+        }
+    }
+    memcpy(st->s, t, sizeof(t));
+}
+
+void rng_substreams_r(rng *dst, int n, int kind, uint64_t seed)
+{
+    splitmix64_state sm     = {seed};
+    mt_state         *mt;
+    uint64_t         key[2] = {seed, 0}, a, b, c, d;
+
+    if (n < 1) return;
+    rng_seed(&dst[0], kind, seed);
+    switch (kind)
+    {
+        case RNG_MT19937:
+            mt = malloc(sizeof(mt_state) * n);
+            if (mt == NULL)
+            {
+                printf("!_malloc failed_!\n");
+                exit(EXIT_FAILURE);
+            }
+            mt_substreams_r(mt, n, (unsigned long) (seed & 0xffffffffUL));
+            for (int i = 0; i < n; i++)
+            {
+                dst[i].kind = RNG_MT19937;
+                dst[i].u.mt = mt[i];
+            }
+            free(mt);
+            break;
+        case RNG_MT19937_64:
+            for (int i = 1; i < n; i++)
+            {
+                dst[i].kind = RNG_MT19937_64;
+                key[1]      = (uint64_t) i;
+                init_by_array64_r(&dst[i].u.mt64, key, 2);
+            }
+            break;
+        case RNG_XOSHIRO256SS:
+            for (int i = 1; i < n; i++)
+            {
+                dst[i] = dst[i - 1];
+                xoshiro256Jump(&dst[i].u.xoshiro);
+            }
+            break;
+        case RNG_PCG64:
+            // same starting words as rng_seed(), then a stream selector of their own, from the same SplitMix64
+            a = splitmix64_next(&sm);
+            b = splitmix64_next(&sm);
+            splitmix64_next(&sm);
+            splitmix64_next(&sm);
+            for (int i = 1; i < n; i++)
+            {
+                dst[i].kind = RNG_PCG64;
+                c           = splitmix64_next(&sm);
+                d           = splitmix64_next(&sm);
+                pcg64_seed(&dst[i].u.pcg, a, b, c, d);
+            }
+            break;
+        case RNG_SPLITMIX64:
+            for (int i = 1; i < n; i++)
+            {
+                dst[i] = dst[i - 1];
+                dst[i].u.splitmix.s += 0x9e3779b97f4a7c15ULL << RNG_SPLITMIX_LOG2; // 2^RNG_SPLITMIX_LOG2 draws
+            }
+            break;
+        default: // RNG_PHILOX4X32
+            for (int i = 1; i < n; i++)
+            {
+                rng_seed_philox(&dst[i], seed, (uint64_t) i);
+            }
+    }
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    GLOBAL     -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* the global engine's state; unused for the MT engines, which have their own global state in mt.c */
+#ifndef RNG_STATIC
+static
+#endif
+rng rng_global = {RNG_MT19937};
+
+/* seeds the global engine: the MT ones through their own global state */
+static void seedGlobal(int kind, uint64_t seed)
+{
+    switch (kind)
+    {
+        case RNG_MT19937:
+            init_genrand((unsigned long) (seed & 0xffffffffUL));
+            break;
+        case RNG_MT19937_64:
+            init_genrand64(seed);
+            break;
+        default:
+            rng_seed(&rng_global, kind, seed);
+    }
+    rng_global.kind = kind;
+}
+
+void rng_get_global(rng *out)
+{
+    *out = rng_global;
+    if (rng_global.kind == RNG_MT19937) mt_get_global(&out->u.mt);
+    if (rng_global.kind == RNG_MT19937_64) mt64_get_global(&out->u.mt64);
+}
+
+void rng_set_global(const rng *in)
+{
+#ifdef RNG_STATIC
+    if (in->kind != RNG_STATIC)
+    {
+        printf("rng_set_global: built with RNG_STATIC=%s, cannot switch to %s\n", rng_name(RNG_STATIC),
+               rng_name(in->kind));
+        exit(EXIT_FAILURE);
+    }
+#endif
+    rng_global = *in;
+    if (in->kind == RNG_MT19937) mt_set_global(&in->u.mt);
+    if (in->kind == RNG_MT19937_64) mt64_set_global(&in->u.mt64);
+}
+
+#ifndef RNG_STATIC
+
+void rng_use(int kind, uint64_t seed)
+{
+    seedGlobal(kind, seed);
+}
+
+int rng_current(void)
+{
+    return rng_global.kind;
+}
+
+uint64_t rng_u64(void)
+{
+    uint64_t hi;
+
+    switch (rng_global.kind)
+    {
+        case RNG_MT19937:
+            hi = genrand_int32(); /* drawn first */
+            return (hi << 32) | genrand_int32();
+        case RNG_MT19937_64:
+            return genrand64_int64();
+        default:
+            return rng_u64_r(&rng_global);
+    }
+}
+
+uint32_t rng_u32(void)
+{
+    if (rng_global.kind == RNG_MT19937) return (uint32_t) genrand_int32();
+    if (rng_global.kind == RNG_PHILOX4X32) return philox4x32_next32(&rng_global.u.philox);
+    return (uint32_t) (rng_u64() >> 32);
+}
+
+double rng_real1(void)
+{
+    if (rng_global.kind == RNG_MT19937) return genrand_real1();
+    return u64_to_real1(rng_u64());
+}
+
+double rng_real2(void)
+{
+    if (rng_global.kind == RNG_MT19937) return genrand_real2();
+    return u64_to_real2(rng_u64());
+}
+
+double rng_real3(void)
+{
+    if (rng_global.kind == RNG_MT19937) return genrand_real3();
+    return u64_to_real3(rng_u64());
+}
+
+#else // RNG_STATIC
+
+/* default seed, as the MT engines get on their first draw: an all-zero state would be stuck for xoshiro256** */
+__attribute__((constructor))
+static void seedStatic(void)
+{
+    if (RNG_STATIC != RNG_MT19937 && RNG_STATIC != RNG_MT19937_64) seedGlobal(RNG_STATIC, 5489ULL);
+}
+
+void rng_use(int kind, uint64_t seed)
+{
+    if (kind != RNG_STATIC)
+    {
+        printf("rng_use: built with RNG_STATIC=%s, cannot switch to %s\n", rng_name(RNG_STATIC), rng_name(kind));
+        exit(EXIT_FAILURE);
+    }
+    seedGlobal(kind, seed);
+}
+
+#endif // RNG_STATIC
+
+void rng_fill_u32(uint32_t *buf, size_t n)
+{
+    if (rng_current() == RNG_MT19937)
+    {
+        genrand_fill_u32(buf, n);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        buf[i] = rng_u32();
+    }
+}
+
+void rng_fill_real1(double *buf, size_t n)
+{
+    if (rng_current() == RNG_MT19937)
+    {
+        genrand_fill_real1(buf, n);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        buf[i] = rng_real1();
+    }
+}
+
+void rng_fill_real2(double *buf, size_t n)
+{
+    if (rng_current() == RNG_MT19937)
+    {
+        genrand_fill_real2(buf, n);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        buf[i] = rng_real2();
+    }
+}
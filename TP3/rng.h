@@ -0,0 +1,399 @@
+//
+// Generator backends: one interface over MT19937, MT19937-64, xoshiro256**, PCG64, SplitMix64 and Philox4x32-10.
+//
+// Runtime selection (default): rng_use() picks the engine behind rng_u32(), rng_real1(), ... for the whole program,
+// MT19937 being the default one, on the same global state as genrand_int32() (so init_by_array() still seeds it).
+// Compile-time selection: building with -DRNG_STATIC=<kind> (e.g. -DRNG_STATIC=RNG_XOSHIRO256SS) turns those
+// into static inline functions on that engine only, so the small engines inline into the callers' loops.
+// Independent generators (one per thread, say) use an rng handle and the _r functions.
+//
+
+#ifndef Y2_C_SIM_RNG_H
+#define Y2_C_SIM_RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mt.h"
+
+/* engine kinds */
+#define RNG_MT19937      0
+#define RNG_MT19937_64   1
+#define RNG_XOSHIRO256SS 2
+#define RNG_PCG64        3
+#define RNG_SPLITMIX64   4
+#define RNG_PHILOX4X32   5
+#define RNG_KINDS        6
+
+#define RNG_SPLITMIX_LOG2 48 /* distance between two splitmix64 substreams of rng_substreams_r(), in draws */
+
+/* xoshiro256** 1.0, Blackman & Vigna, 2018: 256 bits of state */
+typedef struct xoshiro256_state
+{
+    uint64_t s[4];
+} xoshiro256_state;
+
+/* PCG64 (XSL RR 128/64), O'Neill, 2014: a 128-bit LCG and an output permutation */
+typedef struct pcg64_state
+{
+    uint64_t state_hi, state_lo;
+    uint64_t inc_hi, inc_lo; /* stream selector, always odd */
+} pcg64_state;
+
+/* SplitMix64, Steele, Lea & Flood, 2014: 64 bits of state, also used to seed the others */
+typedef struct splitmix64_state
+{
+    uint64_t s;
+} splitmix64_state;
+
+/*
+ * Philox4x32-10, Salmon, Moraes, Dror & Shaw, 2011 (Random123): counter-based, block b of stream s
+ * is philox4x32_10({b, s}, key), 4 words, a pure function of its inputs. The handle only walks the blocks in order,
+ * philox_fill_*() give any range of any stream directly.
+ */
+typedef struct philox4x32_state
+{
+    uint32_t key[2];
+    uint64_t stream;
+    uint64_t block; /* next block to generate */
+    uint32_t buf[4]; /* current block */
+    int      idx;    /* next word of buf, 4 when used up */
+} philox4x32_state;
+
+/* generator handle: any of the engines above */
+typedef struct rng
+{
+    int kind; /* RNG_* */
+    union
+    {
+        mt_state         mt;
+        mt64_state       mt64;
+        xoshiro256_state xoshiro;
+        pcg64_state      pcg;
+        splitmix64_state splitmix;
+        philox4x32_state philox;
+    } u;
+} rng;
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ENGINES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+static inline uint64_t rotl64(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitmix64_next(splitmix64_state *st)
+{
+    uint64_t z = (st->s += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t xoshiro256ss_next(xoshiro256_state *st)
+{
+    uint64_t *s     = st->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t      = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+
+    return result;
+}
+
+/* state = state * multiplier + inc, on 128 bits */
+static inline void pcg64_step(pcg64_state *st)
+{
+    const uint64_t mul_hi = 2549297995355413924ULL, mul_lo = 4865540595714422341ULL;
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 prod = (unsigned __int128) st->state_lo * mul_lo;
+    uint64_t          hi   = (uint64_t) (prod >> 64) + st->state_hi * mul_lo + st->state_lo * mul_hi;
+    uint64_t          lo   = (uint64_t) prod;
+#else
+    /* 64x64 -> 128 multiplication of the low words, by 32-bit halves */
+    uint64_t a0 = st->state_lo & 0xffffffffULL, a1 = st->state_lo >> 32;
+    uint64_t b0 = mul_lo & 0xffffffffULL, b1 = mul_lo >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (p01 & 0xffffffffULL) + (p10 & 0xffffffffULL);
+    uint64_t lo  = (p00 & 0xffffffffULL) | (mid << 32);
+    uint64_t hi  = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32)
+                   + st->state_hi * mul_lo + st->state_lo * mul_hi;
+#endif
+    st->state_lo = lo + st->inc_lo;
+    st->state_hi = hi + st->inc_hi + (st->state_lo < lo);
+}
+
+static inline uint64_t pcg64_next(pcg64_state *st)
+{
+    uint64_t x;
+    int      rot;
+
+    pcg64_step(st);
+    x   = st->state_hi ^ st->state_lo;
+    rot = (int) (st->state_hi >> 58);
+    return (x >> rot) | (x << ((-rot) & 63));
+}
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U /* golden ratio */
+#define PHILOX_W1 0xBB67AE85U /* sqrt(3) - 1 */
+
+/* one Philox4x32-10 block: out = 10 rounds of multiply-xor on ctr, key bumped by a Weyl sequence in between */
+static inline void philox4x32_10(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4])
+{
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    uint64_t p0, p1;
+
+    for (int r = 0; r < 10; r++)
+    {
+        p0 = (uint64_t) PHILOX_M0 * c0;
+        p1 = (uint64_t) PHILOX_M1 * c2;
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t) p1;
+        c3 = (uint32_t) p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+static inline uint32_t philox4x32_next32(philox4x32_state *st)
+{
+    uint32_t ctr[4];
+
+    if (st->idx >= 4)
+    {
+        ctr[0] = (uint32_t) st->block;
+        ctr[1] = (uint32_t) (st->block >> 32);
+        ctr[2] = (uint32_t) st->stream;
+        ctr[3] = (uint32_t) (st->stream >> 32);
+        philox4x32_10(ctr, st->key, st->buf);
+        st->block++;
+        st->idx = 0;
+    }
+    return st->buf[st->idx++];
+}
+
+static inline uint64_t philox4x32_next(philox4x32_state *st)
+{
+    uint64_t hi = philox4x32_next32(st); /* drawn first */
+    return (hi << 32) | philox4x32_next32(st);
+}
+
+/* 64 random bits to a double on [0,1], [0,1) or (0,1), 53-bit resolution (52 for (0,1)) */
+static inline double u64_to_real1(uint64_t x)
+{
+    return (x >> 11) * (1.0 / 9007199254740991.0);
+}
+
+static inline double u64_to_real2(uint64_t x)
+{
+    return (x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static inline double u64_to_real3(uint64_t x)
+{
+    return ((x >> 12) + 0.5) * (1.0 / 4503599627370496.0);
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    HANDLES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* seeds r as a generator of the given kind */
+void rng_seed(rng *r, int kind, uint64_t seed);
+
+/* engine name, e.g. "xoshiro256**", and the other way around (-1 when unknown) */
+const char *rng_name(int kind);
+
+int rng_kind_from_name(const char *name);
+
+/* command line "prog [engine [seed]]": switches the global engine when one is given (seed defaults to 5489) */
+/* exits with the list of engines on an unknown name */
+void rng_use_args(int argc, char **argv);
+
+/* 32 random bits (the upper half of the 64-bit engines' output) */
+uint32_t rng_u32_r(rng *r);
+
+/* 64 random bits (two draws for MT19937) */
+uint64_t rng_u64_r(rng *r);
+
+/* doubles on [0,1], [0,1) and (0,1): same as genrand_real1/2/3 for MT19937, 53-bit for the 64-bit engines */
+double rng_real1_r(rng *r);
+
+double rng_real2_r(rng *r);
+
+double rng_real3_r(rng *r);
+
+/* Philox handle on a given key and stream, at word 0 (rng_seed() uses stream 0) */
+void rng_seed_philox(rng *r, uint64_t key, uint64_t stream);
+
+/* words [first, first + n) of Philox stream (key, stream), as 32-bit words and as doubles on [0,1]: */
+/* however a range is split between calls (or threads), the words are the same */
+void philox_fill_u32(uint64_t key, uint64_t stream, uint64_t first, uint32_t *buf, size_t n);
+
+void philox_fill_real1(uint64_t key, uint64_t stream, uint64_t first, double *buf, size_t n);
+
+/* fills buf with the next n rng_real1_r() outputs, through genrand_fill_real1_r() on mt19937 */
+void rng_fill_real1_r(rng *r, double *buf, size_t n);
+
+/* dst[0..n-1]: substreams 0 to n - 1 of the engine seeded by rng_seed(kind, seed), one per replicate or thread, */
+/* substream 0 being that generator itself. mt19937: mt_substreams_r(); xoshiro256**: its 2^128 jump; splitmix64: */
+/* 2^RNG_SPLITMIX_LOG2 draws apart; PCG64: stream selectors drawn from the seed; Philox: streams 0 to n - 1; */
+/* mt19937-64, which has no jump here: init_by_array64({seed, i}) */
+void rng_substreams_r(rng *dst, int n, int kind, uint64_t seed);
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    GLOBAL     -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* copies the global engine (whichever it is) into a handle, and back: e.g. for checkpoints */
+void rng_get_global(rng *out);
+
+void rng_set_global(const rng *in);
+
+/* fills buf with the next n rng_u32() outputs, through genrand_fill_u32() on mt19937 */
+void rng_fill_u32(uint32_t *buf, size_t n);
+
+/* fills buf with the next n rng_real1() outputs, through genrand_fill_real1() on mt19937 */
+void rng_fill_real1(double *buf, size_t n);
+
+/* fills buf with the next n rng_real2() outputs, through genrand_fill_real2() on mt19937 */
+void rng_fill_real2(double *buf, size_t n);
+
+#ifndef RNG_STATIC
+
+/* selects the engine behind the functions below and seeds it; RNG_MT19937 uses init_genrand() */
+void rng_use(int kind, uint64_t seed);
+
+/* engine currently behind the functions below */
+int rng_current(void);
+
+uint32_t rng_u32(void);
+
+uint64_t rng_u64(void);
+
+double rng_real1(void);
+
+double rng_real2(void);
+
+double rng_real3(void);
+
+#else // RNG_STATIC: one engine, inlined
+
+extern rng rng_global;
+
+#if RNG_STATIC == RNG_MT19937
+static inline uint32_t rng_u32(void)
+{
+    return (uint32_t) genrand_int32();
+}
+
+static inline uint64_t rng_u64(void)
+{
+    uint64_t hi = genrand_int32(); /* drawn first */
+    return (hi << 32) | genrand_int32();
+}
+
+static inline double rng_real1(void)
+{
+    return genrand_real1();
+}
+
+static inline double rng_real2(void)
+{
+    return genrand_real2();
+}
+
+static inline double rng_real3(void)
+{
+    return genrand_real3();
+}
+
+#else
+#if RNG_STATIC == RNG_MT19937_64
+static inline uint64_t rng_u64(void)
+{
+    return genrand64_int64();
+}
+
+#elif RNG_STATIC == RNG_XOSHIRO256SS
+static inline uint64_t rng_u64(void)
+{
+    return xoshiro256ss_next(&rng_global.u.xoshiro);
+}
+
+#elif RNG_STATIC == RNG_PCG64
+static inline uint64_t rng_u64(void)
+{
+    return pcg64_next(&rng_global.u.pcg);
+}
+
+#elif RNG_STATIC == RNG_SPLITMIX64
+static inline uint64_t rng_u64(void)
+{
+    return splitmix64_next(&rng_global.u.splitmix);
+}
+
+#elif RNG_STATIC == RNG_PHILOX4X32
+static inline uint64_t rng_u64(void)
+{
+    return philox4x32_next(&rng_global.u.philox);
+}
+
+#else
+#error "RNG_STATIC must be one of the RNG_* engine kinds"
+#endif
+#if RNG_STATIC == RNG_PHILOX4X32
+/* one word, as rng_u32_r(): not the upper half of rng_u64(), which takes two */
+static inline uint32_t rng_u32(void)
+{
+    return philox4x32_next32(&rng_global.u.philox);
+}
+#else
+static inline uint32_t rng_u32(void)
+{
+    return (uint32_t) (rng_u64() >> 32);
+}
+#endif
+
+static inline double rng_real1(void)
+{
+    return u64_to_real1(rng_u64());
+}
+
+static inline double rng_real2(void)
+{
+    return u64_to_real2(rng_u64());
+}
+
+static inline double rng_real3(void)
+{
+    return u64_to_real3(rng_u64());
+}
+
+#endif
+
+void rng_use(int kind, uint64_t seed); /* only accepts RNG_STATIC */
+
+static inline int rng_current(void)
+{
+    return RNG_STATIC;
+}
+
+
+#endif // RNG_STATIC
+
+#endif //Y2_C_SIM_RNG_H
@@ -0,0 +1,294 @@
+//
+// Work-stealing task scheduler, see sched.h
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "sched.h"
+
+#define SCHED_DEQUE_INIT 64 // tasks, doubled when full
+
+typedef struct sched_task
+{
+    void (*fn)(void *arg);
+    void *arg;
+} sched_task;
+
+/* ring buffer: tasks [top, bottom[ modulo cap, the owner's end being bottom */
+typedef struct sched_deque
+{
+    pthread_mutex_t lock;
+    sched_task      *tasks;
+    size_t          cap;
+    size_t          top, bottom;
+} __attribute__((aligned(64))) sched_deque;
+
+struct sched
+{
+    int             workers;
+    sched_deque     *deques;
+    pthread_t       *threads;
+    pthread_mutex_t lock;      // guards the sleeping and waiting below
+    pthread_cond_t  work;      // a task was queued, or the pool stops
+    pthread_cond_t  idle;      // pending fell to 0
+    unsigned long   queued;    // tasks in the deques (atomic)
+    unsigned long   pending;   // tasks submitted and not done yet (atomic)
+    unsigned int    next;      // deque of the next outside submission (atomic)
+    int             stop;
+};
+
+typedef struct sched_worker_arg
+{
+    sched *s;
+    int   id;
+} sched_worker_arg;
+
+static __thread sched *self_sched = NULL; /* pool of the calling worker, if it is one */
+static __thread int   self_id     = -1;
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+static void push(sched_deque *d, sched_task t)
+{
+    sched_task *grown;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom - d->top == d->cap)
+    {
+        grown = malloc(sizeof(sched_task) * d->cap * 2);
+        if (grown == NULL)
+        {
+            printf("!_malloc failed_!\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = d->top; i < d->bottom; i++)
+        {
+            grown[i - d->top] = d->tasks[i % d->cap];
+        }
+        free(d->tasks);
+        d->tasks  = grown;
+        d->bottom -= d->top;
+        d->top    = 0;
+        d->cap *= 2;
+    }
+    d->tasks[d->bottom++ % d->cap] = t;
+    pthread_mutex_unlock(&d->lock);
+}
+
+/* the owner's end: newest first */
+static int popBottom(sched_deque *d, sched_task *t)
+{
+    int found = 0;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top)
+    {
+        *t    = d->tasks[--d->bottom % d->cap];
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+/* the thieves' end: oldest first */
+static int popTop(sched_deque *d, sched_task *t)
+{
+    int found = 0;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top)
+    {
+        *t    = d->tasks[d->top++ % d->cap];
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+/* own deque first, then the others', starting from a different victim each time */
+static int findTask(sched *s, int id, unsigned int *victim, sched_task *t)
+{
+    if (popBottom(&s->deques[id], t)) return 1;
+    for (int i = 0; i < s->workers; i++)
+    {
+        *victim = *victim * 1103515245U + 12345U;
+        if (popTop(&s->deques[(*victim >> 16) % s->workers], t)) return 1;
+    }
+    for (int i = 0; i < s->workers; i++) // and a full round, not to miss the last task
+    {
+        if (popTop(&s->deques[i], t)) return 1;
+    }
+    return 0;
+}
+
+static void *schedWorker(void *arg)
+{
+    sched_worker_arg *wa     = arg;
+    sched            *s      = wa->s;
+    int              id      = wa->id;
+    unsigned int     victim  = (unsigned int) id * 2654435761U + 1;
+    sched_task       t;
+
+    free(wa);
+    self_sched = s;
+    self_id    = id;
+    for (;;)
+    {
+        if (findTask(s, id, &victim, &t))
+        {
+            __atomic_fetch_sub(&s->queued, 1, __ATOMIC_ACQ_REL);
+            t.fn(t.arg);
+            if (__atomic_sub_fetch(&s->pending, 1, __ATOMIC_ACQ_REL) == 0)
+            {
+                pthread_mutex_lock(&s->lock);
+                pthread_cond_broadcast(&s->idle);
+                pthread_mutex_unlock(&s->lock);
+            }
+            continue;
+        }
+        // nothing anywhere: sleep until a task is queued
+        pthread_mutex_lock(&s->lock);
+        while (!s->stop && __atomic_load_n(&s->queued, __ATOMIC_ACQUIRE) == 0)
+        {
+            pthread_cond_wait(&s->work, &s->lock);
+        }
+        if (s->stop)
+        {
+            pthread_mutex_unlock(&s->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   BUSINESS    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+sched *sched_create(int inWorkers)
+{
+    sched            *s;
+    sched_worker_arg *wa;
+
+    if (inWorkers == 0)
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN); // clamped: only an explicit count can be too large
+
+        inWorkers = n > SCHED_MAX_WORKERS ? SCHED_MAX_WORKERS : (int) n;
+    }
+    if (inWorkers < 1) inWorkers = 1;
+    if (inWorkers > SCHED_MAX_WORKERS)
+    {
+        printf("sched_create: %d workers, expected 1 to %d\n", inWorkers, SCHED_MAX_WORKERS);
+        exit(EXIT_FAILURE);
+    }
+    s = malloc(sizeof(sched));
+    if (s == NULL)
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+    s->workers = inWorkers;
+    s->deques  = aligned_alloc(64, sizeof(sched_deque) * inWorkers);
+    s->threads = malloc(sizeof(pthread_t) * inWorkers);
+    if (s->deques == NULL || s->threads == NULL)
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+    s->queued  = 0;
+    s->pending = 0;
+    s->next    = 0;
+    s->stop    = 0;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->work, NULL);
+    pthread_cond_init(&s->idle, NULL);
+    for (int w = 0; w < inWorkers; w++)
+    {
+        pthread_mutex_init(&s->deques[w].lock, NULL);
+        s->deques[w].tasks  = malloc(sizeof(sched_task) * SCHED_DEQUE_INIT);
+        s->deques[w].cap    = SCHED_DEQUE_INIT;
+        s->deques[w].top    = 0;
+        s->deques[w].bottom = 0;
+        if (s->deques[w].tasks == NULL)
+        {
+            printf("!_malloc failed_!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int w = 0; w < inWorkers; w++)
+    {
+        wa = malloc(sizeof(sched_worker_arg));
+        if (wa == NULL)
+        {
+            printf("!_malloc failed_!\n");
+            exit(EXIT_FAILURE);
+        }
+        wa->s  = s;
+        wa->id = w;
+        if (pthread_create(&s->threads[w], NULL, schedWorker, wa) != 0)
+        {
+            printf("sched_create: could not start worker %d\n", w);
+            exit(EXIT_FAILURE);
+        }
+    }
+    return s;
+}
+
+void sched_submit(sched *s, void (*fn)(void *arg), void *arg)
+{
+    sched_task t  = {fn, arg};
+    int        id = (self_sched == s) ? self_id
+                                      : (int) (__atomic_fetch_add(&s->next, 1, __ATOMIC_RELAXED) % s->workers);
+
+    __atomic_fetch_add(&s->pending, 1, __ATOMIC_ACQ_REL);
+    push(&s->deques[id], t);
+    __atomic_fetch_add(&s->queued, 1, __ATOMIC_ACQ_REL);
+    // under the lock, so that a worker between its check of queued and its wait does not miss it
+    pthread_mutex_lock(&s->lock);
+    pthread_cond_signal(&s->work);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void sched_wait(sched *s)
+{
+    pthread_mutex_lock(&s->lock);
+    while (__atomic_load_n(&s->pending, __ATOMIC_ACQUIRE) > 0)
+    {
+        pthread_cond_wait(&s->idle, &s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+int sched_workers(const sched *s)
+{
+    return s->workers;
+}
+
+void sched_destroy(sched *s)
+{
+    sched_wait(s);
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->work);
+    pthread_mutex_unlock(&s->lock);
+    for (int w = 0; w < s->workers; w++)
+    {
+        pthread_join(s->threads[w], NULL);
+    }
+    for (int w = 0; w < s->workers; w++) // once no worker can be stealing from them
+    {
+        pthread_mutex_destroy(&s->deques[w].lock);
+        free(s->deques[w].tasks);
+    }
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->work);
+    pthread_cond_destroy(&s->idle);
+    free(s->deques);
+    free(s->threads);
+    free(s);
+}
@@ -0,0 +1,58 @@
+//
+// Work-stealing task scheduler: a pool of worker threads, each with its own deque of tasks.
+//
+// A worker runs the newest task of its own deque first (depth first, cache-warm) and, once empty, steals the oldest
+// task of another worker's (the biggest, when tasks split themselves in halves): big tasks spread over the pool, and
+// an idle worker never waits while another one has more than one task queued. Tasks submitted from a worker go to
+// its own deque, tasks submitted from elsewhere to the workers' deques in turn.
+//
+// Tasks must not depend on the order they run in: give each one its own generator substream (a Philox stream, or an
+// MT19937 jump), its own result slot, and assemble the results once sched_wait() returns.
+//
+
+#ifndef Y2_C_SIM_SCHED_H
+#define Y2_C_SIM_SCHED_H
+
+#define SCHED_MAX_WORKERS 256
+
+typedef struct sched sched;
+
+/**
+ * sched_create
+ * starts a pool of worker threads, idle until tasks come
+ * @param inWorkers number of workers (1 to SCHED_MAX_WORKERS), 0 for one per online CPU (SCHED_MAX_WORKERS at most)
+ * @return said pool
+ */
+sched *sched_create(int inWorkers);
+
+/**
+ * sched_submit
+ * queues fn(arg), from any thread, tasks included
+ * @param s pool
+ * @param fn task
+ * @param arg passed to fn, must live until it has run
+ */
+void sched_submit(sched *s, void (*fn)(void *arg), void *arg);
+
+/**
+ * sched_wait
+ * returns once every task submitted so far, and every task they submitted, has run
+ * @param s pool
+ */
+void sched_wait(sched *s);
+
+/**
+ * sched_workers
+ * @param s pool
+ * @return its number of workers
+ */
+int sched_workers(const sched *s);
+
+/**
+ * sched_destroy
+ * waits for the tasks, then stops the workers and frees the pool
+ * @param s pool
+ */
+void sched_destroy(sched *s);
+
+#endif //Y2_C_SIM_SCHED_H
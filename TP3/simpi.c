@@ -0,0 +1,336 @@
+//
+// Parallel Monte Carlo estimation of pi, see simpi.h
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "mt.h"
+#include "simpi.h"
+
+#define SIMPI_BATCH 1024 // points per batch of uniforms
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(MT_NO_SIMD)
+#define SIMPI_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* one per thread, on its own cache lines: the counters are written to all along */
+typedef struct simpi_task
+{
+    mt_state           st;
+    unsigned long long points;
+    unsigned long long hits;
+} __attribute__((aligned(64))) simpi_task;
+
+static int simpi_simd_max = SIMPI_SIMD_AVX512; /* lowered by simPi_simd_select() */
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+int simPi_default_threads(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (n < 1) return 1;
+    return n > SIMPI_MAX_THREADS ? SIMPI_MAX_THREADS : (int) n;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------  HIT COUNTING  ----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* out of line: inlined into the AVX-512 kernel, it could be compiled with fused multiply-adds */
+__attribute__((noinline))
+static unsigned long long hitsScalar(const double *xy, size_t n)
+{
+    unsigned long long hits = 0;
+
+    for (size_t k = 0; k < n; k++)
+    {
+        hits += (xy[2 * k] * xy[2 * k] + xy[2 * k + 1] * xy[2 * k + 1] < 1);
+    }
+    return hits;
+}
+
+#ifdef SIMPI_X86_SIMD
+
+/*
+ * 4 points per step: hadd() sums the squares pairwise, x * x + y * y as the scalar code does,
+ * and the lanes that are below 1 (all ones) are subtracted from 4 counters
+ */
+__attribute__((target("avx2")))
+static unsigned long long hitsAvx2(const double *xy, size_t n)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256i       acc = _mm256_setzero_si256();
+    __m256d       a, b, r;
+    uint64_t      lanes[4];
+    size_t        k   = 0;
+
+    for (; k + 4 <= n; k += 4)
+    {
+        a   = _mm256_loadu_pd(xy + 2 * k);     /* x0 y0 x1 y1 */
+        b   = _mm256_loadu_pd(xy + 2 * k + 4); /* x2 y2 x3 y3 */
+        r   = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+        acc = _mm256_sub_epi64(acc, _mm256_castpd_si256(_mm256_cmp_pd(r, one, _CMP_LT_OQ)));
+    }
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + hitsScalar(xy + 2 * k, n - k);
+}
+
+/* 8 points per step: the squares are split into x and y lanes, added, compared into a mask and popcounted */
+__attribute__((target("avx512f,popcnt")))
+static unsigned long long hitsAvx512(const double *xy, size_t n)
+{
+    const __m512d one  = _mm512_set1_pd(1.0);
+    const __m512i even = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i odd  = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    __m512d       a, b, r;
+    unsigned long long hits = 0;
+    size_t        k    = 0;
+
+    for (; k + 8 <= n; k += 8)
+    {
+        a = _mm512_loadu_pd(xy + 2 * k);
+        b = _mm512_loadu_pd(xy + 2 * k + 8);
+        a = _mm512_mul_pd(a, a);
+        b = _mm512_mul_pd(b, b);
+        r = _mm512_add_pd(_mm512_permutex2var_pd(a, even, b), _mm512_permutex2var_pd(a, odd, b));
+        hits += __builtin_popcount(_mm512_cmp_pd_mask(r, one, _CMP_LT_OQ));
+    }
+    return hits + hitsScalar(xy + 2 * k, n - k);
+}
+
+#endif // SIMPI_X86_SIMD
+
+/* best SIMPI_SIMD_* level both allowed by simpi_simd_max and supported by this CPU */
+static int simPiSimdLevel(void)
+{
+#ifdef SIMPI_X86_SIMD
+    if (simpi_simd_max >= SIMPI_SIMD_AVX512 && __builtin_cpu_supports("avx512f")) return SIMPI_SIMD_AVX512;
+    if (simpi_simd_max >= SIMPI_SIMD_AVX2 && __builtin_cpu_supports("avx2")) return SIMPI_SIMD_AVX2;
+#endif
+    return SIMPI_SIMD_SCALAR;
+}
+
+int simPi_simd_select(int max_level)
+{
+    simpi_simd_max = max_level;
+    return simPiSimdLevel();
+}
+
+unsigned long long simPi_hits(const double *xy, size_t n)
+{
+    switch (simPiSimdLevel())
+    {
+#ifdef SIMPI_X86_SIMD
+        case SIMPI_SIMD_AVX512:
+            return hitsAvx512(xy, n);
+        case SIMPI_SIMD_AVX2:
+            return hitsAvx2(xy, n);
+#endif
+        default:
+            return hitsScalar(xy, n);
+    }
+}
+
+/*-------------------------------------------------------------------------------*/
+/*--------------------------  INTEGER HIT COUNTING  -----------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* u * u < R - v * v, R - v * v never being negative */
+static unsigned long long hitsU32Scalar(const uint32_t *uv, size_t n)
+{
+    unsigned long long hits = 0;
+    uint64_t           u, v;
+
+    for (size_t k = 0; k < n; k++)
+    {
+        u = uv[2 * k];
+        v = uv[2 * k + 1];
+        hits += (u * u < SIMPI_R32 - v * v);
+    }
+    return hits;
+}
+
+#ifdef SIMPI_X86_SIMD
+
+/*
+ * 4 points per step, one per 64-bit lane (u low, v high): mul_epu32() squares the low halves.
+ * AVX2 only compares signed 64-bit integers, hence the flipped sign bits
+ */
+__attribute__((target("avx2")))
+static unsigned long long hitsU32Avx2(const uint32_t *uv, size_t n)
+{
+    const __m256i r    = _mm256_set1_epi64x((long long) SIMPI_R32);
+    const __m256i sign = _mm256_set1_epi64x((long long) 0x8000000000000000ULL);
+    __m256i       acc  = _mm256_setzero_si256();
+    __m256i       a, u2, rest;
+    uint64_t      lanes[4];
+    size_t        k    = 0;
+
+    for (; k + 4 <= n; k += 4)
+    {
+        a    = _mm256_loadu_si256((const __m256i *) (uv + 2 * k));
+        u2   = _mm256_xor_si256(_mm256_mul_epu32(a, a), sign);
+        a    = _mm256_srli_epi64(a, 32);
+        rest = _mm256_xor_si256(_mm256_sub_epi64(r, _mm256_mul_epu32(a, a)), sign);
+        acc  = _mm256_sub_epi64(acc, _mm256_cmpgt_epi64(rest, u2));
+    }
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + hitsU32Scalar(uv + 2 * k, n - k);
+}
+
+/* 8 points per step, with an unsigned compare into a mask */
+__attribute__((target("avx512f,popcnt")))
+static unsigned long long hitsU32Avx512(const uint32_t *uv, size_t n)
+{
+    const __m512i      r    = _mm512_set1_epi64((long long) SIMPI_R32);
+    __m512i            a, u2, rest;
+    unsigned long long hits = 0;
+    size_t             k    = 0;
+
+    for (; k + 8 <= n; k += 8)
+    {
+        a    = _mm512_loadu_si512(uv + 2 * k);
+        u2   = _mm512_mul_epu32(a, a);
+        a    = _mm512_srli_epi64(a, 32);
+        rest = _mm512_sub_epi64(r, _mm512_mul_epu32(a, a));
+        hits += __builtin_popcount(_mm512_cmplt_epu64_mask(u2, rest));
+    }
+    return hits + hitsU32Scalar(uv + 2 * k, n - k);
+}
+
+#endif // SIMPI_X86_SIMD
+
+unsigned long long simPi_hits_u32(const uint32_t *uv, size_t n)
+{
+    switch (simPiSimdLevel())
+    {
+#ifdef SIMPI_X86_SIMD
+        case SIMPI_SIMD_AVX512:
+            return hitsU32Avx512(uv, n);
+        case SIMPI_SIMD_AVX2:
+            return hitsU32Avx2(uv, n);
+#endif
+        default:
+            return hitsU32Scalar(uv, n);
+    }
+}
+
+#ifndef __SIZEOF_INT128__
+/* 128-bit a * a as hi:lo, from 32-bit halves */
+static void square128(uint64_t a, uint64_t *hi, uint64_t *lo)
+{
+    uint64_t a0 = a & 0xffffffffULL, a1 = a >> 32;
+    uint64_t mid = a0 * a1; /* twice */
+    uint64_t low = a0 * a0, carry;
+
+    *lo   = low + (mid << 33);
+    carry = *lo < low;
+    *hi   = a1 * a1 + (mid >> 31) + carry;
+}
+#endif
+
+/* u * u + v * v < 2^128: the sum does not carry out of 128 bits */
+unsigned long long simPi_hits_u64(const uint64_t *uv, size_t n)
+{
+    unsigned long long hits = 0;
+
+    for (size_t k = 0; k < n; k++)
+    {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 u = uv[2 * k], v = uv[2 * k + 1], sum;
+        hits += !__builtin_add_overflow(u * u, v * v, &sum);
+#else
+        uint64_t uh, ul, vh, vl, lo, hi;
+        square128(uv[2 * k], &uh, &ul);
+        square128(uv[2 * k + 1], &vh, &vl);
+        lo = ul + vl;
+        hi = uh + vh;
+        hits += (hi >= uh) && (hi + (lo < ul) >= hi); /* no carry out of either half */
+#endif
+    }
+    return hits;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   BUSINESS    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* counts the hits of task->points points drawn from task->st, x then y, as simPi() does */
+static void *simPiWorker(void *arg)
+{
+    simpi_task         *task = arg;
+    double             xy[2 * SIMPI_BATCH];
+    unsigned long long hits  = 0, done = 0;
+    size_t             n;
+
+    while (done < task->points)
+    {
+        n = (task->points - done < SIMPI_BATCH) ? (size_t) (task->points - done) : SIMPI_BATCH;
+        genrand_fill_real1_r(&task->st, xy, 2 * n);
+        hits += simPi_hits(xy, n);
+        done += n;
+    }
+    task->hits = hits;
+    return NULL;
+}
+
+double simPi_threads(unsigned long long inPoints, unsigned long inSeed, int inThreads)
+{
+    simpi_task         *tasks;
+    pthread_t          *threads;
+    mt_state           *streams;
+    unsigned long long hits = 0;
+    int                t;
+
+    if (inThreads == 0) inThreads = simPi_default_threads();
+    if (inThreads < 1 || inThreads > SIMPI_MAX_THREADS)
+    {
+        printf("simPi_threads: %d threads, expected 1 to %d\n", inThreads, SIMPI_MAX_THREADS);
+        exit(EXIT_FAILURE);
+    }
+    tasks   = aligned_alloc(64, sizeof(simpi_task) * inThreads);
+    threads = malloc(sizeof(pthread_t) * inThreads);
+    streams = malloc(sizeof(mt_state) * inThreads);
+    if (tasks == NULL || threads == NULL || streams == NULL)
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+    mt_substreams_r(streams, inThreads, inSeed);
+
+    // one substream per thread, points split as evenly as possible
+    for (t = 0; t < inThreads; t++)
+    {
+        tasks[t].st     = streams[t];
+        tasks[t].points = inPoints / inThreads + ((unsigned long long) t < inPoints % inThreads);
+        tasks[t].hits   = 0;
+    }
+    for (t = 1; t < inThreads; t++)
+    {
+        if (pthread_create(&threads[t], NULL, simPiWorker, &tasks[t]) != 0)
+        {
+            printf("simPi_threads: could not start thread %d\n", t);
+            exit(EXIT_FAILURE);
+        }
+    }
+    simPiWorker(&tasks[0]); // the calling thread takes the first share
+    for (t = 1; t < inThreads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+
+    for (t = 0; t < inThreads; t++)
+    {
+        hits += tasks[t].hits;
+    }
+    free(tasks);
+    free(threads);
+    free(streams);
+    return (hits / (double) inPoints) * 4;
+}
@@ -0,0 +1,93 @@
+//
+// Parallel Monte Carlo estimation of pi: the points are split between threads, each on its own MT19937 substream.
+//
+// The hits are counted by SIMD kernels (AVX-512, AVX2, scalar fallback, picked at run time) on blocks of uniforms,
+// which give the same count as the scalar x * x + y * y < 1 test: same products, same sum, no fused multiply-add.
+//
+// Thread t of T starts 2^SIMPI_JUMP_LOG2 draws after thread t - 1 on the sequence seeded by init_genrand(seed),
+// so the streams never overlap (each thread draws 2 * inPoints / T < 2^SIMPI_JUMP_LOG2 numbers), and counts its hits
+// in its own counter. The counts are integers, summed in thread order: a given (seed, # of threads) always gives
+// the same estimate, whatever the scheduling.
+//
+
+#ifndef Y2_C_SIM_SIMPI_H
+#define Y2_C_SIM_SIMPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mt.h"
+
+#define SIMPI_JUMP_LOG2 MT_SUBSTREAM_LOG2 // distance between two threads' streams, in draws
+#define SIMPI_MAX_THREADS 256
+
+/* hit-counting kernels */
+#define SIMPI_SIMD_SCALAR 0
+#define SIMPI_SIMD_AVX2   1
+#define SIMPI_SIMD_AVX512 2
+
+/**
+ * simPi_threads
+ * approximates pi with inPoints random points in the unit square, over inThreads threads
+ * <br>the first call also finds the jump polynomial (a fraction of a second)
+ * @param inPoints number of random points
+ * @param inSeed seed, as for init_genrand()
+ * @param inThreads number of threads (1 to SIMPI_MAX_THREADS), 0 for one per online CPU
+ * @return said approximation of pi
+ */
+double simPi_threads(unsigned long long inPoints, unsigned long inSeed, int inThreads);
+
+/**
+ * simPi_default_threads
+ * @return the number of threads used when asking for 0: one per online CPU
+ */
+int simPi_default_threads(void);
+
+/**
+ * simPi_hits
+ * counts the points inside the quarter disc, point k being (xy[2k], xy[2k + 1])
+ * @param xy 2 * n uniforms, x then y, as drawn
+ * @param n number of points
+ * @return number of points such that x * x + y * y < 1
+ */
+unsigned long long simPi_hits(const double *xy, size_t n);
+
+/*
+ * Integer-domain hit counting: the same test on raw generator words, without converting them to doubles.
+ * 32-bit words: genrand_real1() maps u to x = u / (2^32 - 1), so x * x + y * y < 1 is u * u + v * v < R,
+ * R = (2^32 - 1)^2. The sum can reach 2R > 2^64, hence the test as u * u < R - v * v, exact on 64 bits.
+ * 64-bit words: x = u / 2^64 (as genrand64_real2()), so the test is u * u + v * v < 2^128, exact on 128 bits.
+ * Either way, 4 * hits / points is the real-valued estimator of simPi(), only without rounding: it counts the
+ * points of a 2^32 by 2^32 (or 2^64 by 2^64) grid inside the quarter disc, whose share differs from pi / 4 by
+ * O(2^-32), far below the standard error of any feasible run. A replicate is still a mean of independent
+ * Bernoulli draws, so the confidence intervals of section 3 apply as they are. On the same words, the count matches
+ * simPi_hits() on genrand_real1() outputs except for points within a rounding error (~1e-16) of the circle.
+ */
+#define SIMPI_R32 18446744065119617025ULL // (2^32 - 1)^2
+
+/**
+ * simPi_hits_u32
+ * counts the points inside the quarter disc, point k being (uv[2k], uv[2k + 1]) in 32-bit words
+ * @param uv 2 * n genrand_int32() outputs (or any 32-bit words), u then v, as drawn
+ * @param n number of points
+ * @return number of points such that u * u + v * v < (2^32 - 1)^2
+ */
+unsigned long long simPi_hits_u32(const uint32_t *uv, size_t n);
+
+/**
+ * simPi_hits_u64
+ * counts the points inside the quarter disc, point k being (uv[2k], uv[2k + 1]) in 64-bit words
+ * @param uv 2 * n genrand64_int64() outputs (or any 64-bit words), u then v, as drawn
+ * @param n number of points
+ * @return number of points such that u * u + v * v < 2^128
+ */
+unsigned long long simPi_hits_u64(const uint64_t *uv, size_t n);
+
+/**
+ * simPi_simd_select
+ * caps the hit-counting kernels at a given SIMPI_SIMD_* level (e.g. to check them against the scalar one)
+ * @param max_level said level
+ * @return the level actually used, the best one both allowed and supported by this CPU
+ */
+int simPi_simd_select(int max_level);
+
+#endif //Y2_C_SIM_SIMPI_H
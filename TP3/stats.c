@@ -0,0 +1,157 @@
+//
+// Replicate statistics, see stats.h
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "stats.h"
+
+#define CF_MAX_ITER 300
+#define CF_EPS 1e-15
+#define CF_TINY 1e-300
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    WELFORD    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+void welford_add(welford *w, double x)
+{
+    double delta = x - w->mean;
+
+    w->n++;
+    w->mean += delta / (double) w->n;
+    w->m2 += delta * (x - w->mean);
+}
+
+double welford_var(const welford *w)
+{
+    return w->n < 2 ? 0.0 : w->m2 / (double) (w->n - 1);
+}
+
+double welford_std_err(const welford *w)
+{
+    return w->n < 1 ? 0.0 : sqrt(welford_var(w) / (double) w->n);
+}
+
+double welford_radius(const welford *w, double inConf)
+{
+    if (w->n < 2)
+    {
+        printf("welford_radius: needs 2 replicates or more\n");
+        exit(EXIT_FAILURE);
+    }
+    return student_t_quantile((1 + inConf) / 2, (double) (w->n - 1)) * welford_std_err(w);
+}
+
+/*-------------------------------------------------------------------------------*/
+/*----------------------------    STUDENT'S T    --------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* continued fraction of the incomplete beta function, by the modified Lentz method */
+static double betaCf(double a, double b, double x)
+{
+    double c = 1.0, d = 1.0 - (a + b) * x / (a + 1.0), h, num, del;
+    int    m2;
+
+    if (fabs(d) < CF_TINY) d = CF_TINY;
+    d = 1.0 / d;
+    h = d;
+    for (int m = 1; m <= CF_MAX_ITER; m++)
+    {
+        m2  = 2 * m;
+        // even step
+        num = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d   = 1.0 + num * d;
+        c   = 1.0 + num / c;
+        if (fabs(d) < CF_TINY) d = CF_TINY;
+        if (fabs(c) < CF_TINY) c = CF_TINY;
+        d = 1.0 / d;
+        h *= d * c;
+        // odd step
+        num = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d   = 1.0 + num * d;
+        c   = 1.0 + num / c;
+        if (fabs(d) < CF_TINY) d = CF_TINY;
+        if (fabs(c) < CF_TINY) c = CF_TINY;
+        d   = 1.0 / d;
+        del = d * c;
+        h *= del;
+        if (fabs(del - 1.0) < CF_EPS) break;
+    }
+    return h;
+}
+
+/* regularized incomplete beta function I_x(a, b) */
+static double betaInc(double a, double b, double x)
+{
+    double front;
+
+    if (x <= 0.0) return 0.0;
+    if (x >= 1.0) return 1.0;
+    front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log1p(-x));
+    // the continued fraction converges fast below (a + 1) / (a + b + 2), and I_x(a, b) = 1 - I_{1-x}(b, a)
+    if (x < (a + 1.0) / (a + b + 2.0)) return front * betaCf(a, b, x) / a;
+    return 1.0 - front * betaCf(b, a, 1.0 - x) / b;
+}
+
+double student_t_cdf(double t, double df)
+{
+    double tail = 0.5 * betaInc(df / 2.0, 0.5, df / (df + t * t)); // P(T > |t|)
+
+    return t >= 0 ? 1.0 - tail : tail;
+}
+
+double student_t_quantile(double p, double df)
+{
+    double lo = 0.0, hi = 1.0, mid;
+
+    if (p <= 0.0 || p >= 1.0 || df <= 0.0)
+    {
+        printf("student_t_quantile: p = %g, df = %g, expected 0 < p < 1 and df > 0\n", p, df);
+        exit(EXIT_FAILURE);
+    }
+    if (p < 0.5) return -student_t_quantile(1.0 - p, df);
+
+    // bracketing, then bisection: the cdf is increasing, and 200 halvings get down to the last bit
+    while (student_t_cdf(hi, df) < p)
+    {
+        lo = hi;
+        hi *= 2.0;
+    }
+    for (int i = 0; i < 200 && hi - lo > 1e-15 * hi; i++)
+    {
+        mid = 0.5 * (lo + hi);
+        if (student_t_cdf(mid, df) < p)
+        {
+            lo = mid;
+        } else
+        {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+/*-------------------------------------------------------------------------------*/
+/*----------------------------    SEQUENTIAL    ---------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+int seq_estimate(double (*draw)(void *ctx), void *ctx, double inTarget, double inConf,
+                 unsigned long long inMinReps, unsigned long long inMaxReps, welford *out)
+{
+    welford w = WELFORD_INIT;
+
+    if (inMinReps < 2) inMinReps = 2;
+    while (w.n < inMaxReps)
+    {
+        welford_add(&w, draw(ctx));
+        if (w.n >= inMinReps && welford_radius(&w, inConf) <= inTarget)
+        {
+            *out = w;
+            return 1;
+        }
+    }
+    *out = w;
+    return 0;
+}
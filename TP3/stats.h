@@ -0,0 +1,71 @@
+//
+// Replicate statistics: streaming mean and variance, Student's t quantiles, sequential stopping on a target
+// confidence radius.
+//
+
+#ifndef Y2_C_SIM_STATS_H
+#define Y2_C_SIM_STATS_H
+
+/* running mean and sum of squared deviations (Welford, 1962): one pass, no cancellation */
+typedef struct welford
+{
+    unsigned long long n;
+    double             mean;
+    double             m2;
+} welford;
+
+#define WELFORD_INIT {0ULL, 0.0, 0.0}
+
+/* adds one replicate */
+void welford_add(welford *w, double x);
+
+/* unbiased variance estimate (n - 1 denominator), 0 below 2 replicates */
+double welford_var(const welford *w);
+
+/* standard error of the mean: sqrt(var / n) */
+double welford_std_err(const welford *w);
+
+/**
+ * welford_radius
+ * confidence radius of the mean: t_{(1 + inConf) / 2, n - 1} * standard error
+ * @param w replicates so far (at least 2)
+ * @param inConf confidence level, e.g. 0.95
+ * @return said radius
+ */
+double welford_radius(const welford *w, double inConf);
+
+/**
+ * student_t_cdf
+ * @param t value
+ * @param df degrees of freedom (> 0)
+ * @return P(T <= t) for T following Student's t distribution with df degrees of freedom
+ */
+double student_t_cdf(double t, double df);
+
+/**
+ * student_t_quantile
+ * inverse of student_t_cdf(), e.g. 12.706 for (0.975, 1), 2.042 for (0.975, 30)
+ * @param p probability, in ]0, 1[
+ * @param df degrees of freedom (> 0)
+ * @return t such that P(T <= t) = p
+ */
+double student_t_quantile(double p, double df);
+
+/**
+ * seq_estimate
+ * sequential estimation: draws replicates until the confidence radius of their mean falls to inTarget or below
+ * <br>the radius only gets checked from inMinReps replicates on: too few of them make for a rough variance,
+ * and a lucky small one would stop the run too early
+ * @param draw draws one replicate
+ * @param ctx passed to draw
+ * @param inTarget confidence radius to reach
+ * @param inConf confidence level, e.g. 0.95
+ * @param inMinReps minimum number of replicates (at least 2)
+ * @param inMaxReps maximum number of replicates, stopping there even if inTarget was not reached
+ * @param out replicates drawn, their mean and variance
+ * @return 1 if inTarget was reached, 0 otherwise
+ */
+int seq_estimate(double (*draw)(void *ctx), void *ctx, double inTarget, double inConf,
+                 unsigned long long inMinReps, unsigned long long inMaxReps, welford *out);
+
+#endif //Y2_C_SIM_STATS_H
@@ -0,0 +1,178 @@
+//
+// Variance reduction, see vr.h
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rng.h"
+#include "stats.h"
+#include "vr.h"
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------    ANNEXES    -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+/* uniform integer in [0, n[, by Lemire's multiply-shift (bias below n / 2^32, far below anything measured here) */
+static unsigned long below(unsigned long n)
+{
+    return (unsigned long) (((uint64_t) rng_u32() * n) >> 32);
+}
+
+/* random permutation of [0, n[ (Fisher-Yates) */
+static void shuffle(unsigned long *perm, unsigned long n)
+{
+    unsigned long j, tmp;
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        perm[i] = i;
+    }
+    for (unsigned long i = n - 1; i > 0; i--)
+    {
+        j       = below(i + 1);
+        tmp     = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------  ESTIMATORS   -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+double vr_plain(const vr_problem *p, unsigned long n)
+{
+    double sum = 0.0, x, y;
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        x = rng_real3();
+        y = rng_real3();
+        sum += p->f(x, y, p->ctx);
+    }
+    return sum / (double) n;
+}
+
+double vr_antithetic(const vr_problem *p, unsigned long n)
+{
+    double        sum   = 0.0, x, y;
+    unsigned long pairs = n / 2;
+
+    for (unsigned long i = 0; i < pairs; i++)
+    {
+        x = rng_real3();
+        y = rng_real3();
+        sum += p->f(x, y, p->ctx) + p->f(1.0 - x, 1.0 - y, p->ctx);
+    }
+    return sum / (double) (2 * pairs);
+}
+
+double vr_stratified(const vr_problem *p, unsigned long n)
+{
+    unsigned long k   = (unsigned long) sqrt((double) n);
+    double        sum = 0.0, h, x, y;
+
+    while ((k + 1) * (k + 1) <= n) k++; // sqrt() rounding
+    h = 1.0 / (double) k;
+    for (unsigned long i = 0; i < k; i++)
+    {
+        for (unsigned long j = 0; j < k; j++)
+        {
+            x = (i + rng_real2()) * h;
+            y = (j + rng_real2()) * h;
+            sum += p->f(x, y, p->ctx);
+        }
+    }
+    return sum / (double) (k * k);
+}
+
+double vr_lhs(const vr_problem *p, unsigned long n)
+{
+    unsigned long *rows = malloc(sizeof(unsigned long) * n);
+    unsigned long *cols = malloc(sizeof(unsigned long) * n);
+    double        sum   = 0.0, x, y;
+
+    if (rows == NULL || cols == NULL)
+    {
+        printf("!_malloc failed_!\n");
+        exit(EXIT_FAILURE);
+    }
+    shuffle(rows, n);
+    shuffle(cols, n);
+    for (unsigned long i = 0; i < n; i++)
+    {
+        x = (rows[i] + rng_real2()) / (double) n;
+        y = (cols[i] + rng_real2()) / (double) n;
+        sum += p->f(x, y, p->ctx);
+    }
+    free(rows);
+    free(cols);
+    return sum / (double) n;
+}
+
+double vr_control(const vr_problem *p, unsigned long n)
+{
+    // running means and co-moments of f and g, as welford_add() does for one variable
+    double meanF = 0.0, meanG = 0.0, cFG = 0.0, m2G = 0.0, x, y, f, g, dF, dG;
+
+    if (p->g == NULL)
+    {
+        printf("vr_control: no control variate\n");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned long i = 1; i <= n; i++)
+    {
+        x = rng_real3();
+        y = rng_real3();
+        f = p->f(x, y, p->ctx);
+        g = p->g(x, y, p->ctx);
+        dF = f - meanF;
+        dG = g - meanG;
+        meanF += dF / (double) i;
+        meanG += dG / (double) i;
+        cFG += dF * (g - meanG);
+        m2G += dG * (g - meanG);
+    }
+    return m2G > 0.0 ? meanF - (cFG / m2G) * (meanG - p->gMean) : meanF;
+}
+
+/*-------------------------------------------------------------------------------*/
+/*-----------------------------   REPORTING   -----------------------------------*/
+/*-------------------------------------------------------------------------------*/
+
+void vr_report(const vr_problem *p, const char **inNames, const vr_estimator *inEst, int inCount,
+               unsigned long n, int inReps)
+{
+    double  plainVar = 0.0, plainTime = 0.0, t0, t, vrf;
+    welford w;
+
+    printf("%-12s %12s %12s %14s %10s %10s\n", "estimator", "mean", "conf. radius", "variance", "VRF",
+           "efficiency");
+    for (int e = -1; e < inCount; e++) // -1: plain, the reference
+    {
+        w  = (welford) WELFORD_INIT;
+        t0 = now();
+        for (int r = 0; r < inReps; r++)
+        {
+            welford_add(&w, e < 0 ? vr_plain(p, n) : inEst[e](p, n));
+        }
+        t = now() - t0;
+        if (e < 0)
+        {
+            plainVar  = welford_var(&w);
+            plainTime = t;
+        }
+        vrf = welford_var(&w) > 0.0 ? plainVar / welford_var(&w) : INFINITY;
+        printf("%-12s %12.8f %12.8f %14.10f %10.2f %10.2f\n", e < 0 ? "plain" : inNames[e], w.mean,
+               welford_radius(&w, 0.95), welford_var(&w), vrf, vrf * plainTime / t);
+    }
+}
@@ -0,0 +1,58 @@
+//
+// Variance reduction for Monte Carlo estimates of an integral over the unit square, E[f(U, V)] with U, V uniform:
+// the simPi() pattern, f being 4 times the indicator function of the quarter disc, but any f goes.
+//
+// Each estimator draws one replicate from n evaluations of f, on the global generator, inside the open square
+// (rng_real3(), so that u and 1 - u both stay off the edges, where an inverse transform is infinite). The variance of
+// R such replicates, against that of plain ones with as many evaluations, is the variance reduction factor (VRF):
+// a method with a VRF of 10 needs 10 times fewer evaluations for the same confidence radius. Dividing by its
+// relative cost per evaluation gives its efficiency, to pick the cheapest estimator for a job.
+//
+//   plain        mean of f(u, v)
+//   antithetic   n / 2 pairs (u, v), (1 - u, 1 - v): helps when f is monotonic in each coordinate
+//   stratified   one point in each of k * k equal cells of the square (n rounded down to k^2)
+//   lhs          Latin hypercube: n points, one per row and one per column of an n * n grid
+//   control      mean of f - b (mean of g - E[g]), g being a control variate of known mean, and
+//                b = cov(f, g) / var(g) estimated along the way from the same evaluations
+//
+
+#ifndef Y2_C_SIM_VR_H
+#define Y2_C_SIM_VR_H
+
+/* an integrand, and a control variate for it */
+typedef struct vr_problem
+{
+    double (*f)(double x, double y, void *ctx);
+    double (*g)(double x, double y, void *ctx); /* control variate, NULL if none */
+    double gMean;                               /* its exact mean over the unit square */
+    void   *ctx;                                /* passed to f and g */
+} vr_problem;
+
+/* estimator: one replicate from n evaluations */
+typedef double (*vr_estimator)(const vr_problem *p, unsigned long n);
+
+double vr_plain(const vr_problem *p, unsigned long n);
+
+double vr_antithetic(const vr_problem *p, unsigned long n);
+
+double vr_stratified(const vr_problem *p, unsigned long n);
+
+double vr_lhs(const vr_problem *p, unsigned long n);
+
+double vr_control(const vr_problem *p, unsigned long n);
+
+/**
+ * vr_report
+ * runs inReps replicates of each estimator, plain ones first, and prints their mean, confidence radius,
+ * variance, VRF against plain and efficiency (VRF times the cost ratio)
+ * @param p problem
+ * @param inNames names of the estimators
+ * @param inEst said estimators
+ * @param inCount number of estimators
+ * @param n evaluations per replicate
+ * @param inReps replicates per estimator (at least 2)
+ */
+void vr_report(const vr_problem *p, const char **inNames, const vr_estimator *inEst, int inCount,
+               unsigned long n, int inReps);
+
+#endif //Y2_C_SIM_VR_H